@@ -0,0 +1,64 @@
+#pragma once
+
+// Pieces shared by the benchmarks, so their chunk placement, timing and
+// command line stay the same
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+
+namespace Bench {
+    struct Options {
+        int iterations = 0;
+        std::string jsonPath; // Empty when no JSON is written
+    };
+
+    // Chunks far from the origin, so World's own chunks are never neighbors
+    inline glm::ivec3 chunkPosition(int i) {
+        return glm::ivec3(1000 + i % 4, 0, 1000 + i / 4);
+    }
+
+    // Seconds spent in `work`
+    template <typename F>
+    double timed(F&& work) {
+        auto start = std::chrono::steady_clock::now();
+        work();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // [--iterations N] [--json FILE]; prints the usage and returns nothing on anything else
+    inline std::optional<Options> parseOptions(int argc, char** argv, int defaultIterations) {
+        Options options;
+        options.iterations = defaultIterations;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+                options.iterations = std::max(1, std::atoi(argv[++i]));
+            } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+                options.jsonPath = argv[++i];
+            } else {
+                std::cout << "Usage: " << argv[0] << " [--iterations N] [--json FILE]" << std::endl;
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    // Calls `write` with the opened file when a JSON path was given
+    template <typename F>
+    bool writeJson(const Options& options, F&& write) {
+        if (options.jsonPath.empty()) return true;
+        std::ofstream file(options.jsonPath);
+        if (!file) {
+            std::cout << "Failed to open " << options.jsonPath << std::endl;
+            return false;
+        }
+        write(file);
+        return true;
+    }
+}
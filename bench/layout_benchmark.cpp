@@ -0,0 +1,186 @@
+// Block layout benchmark. Built once per BLOCK_LAYOUT (layout_benchmark_y_major,
+// layout_benchmark_column_major, layout_benchmark_morton) and times the workloads
+// whose access patterns the layouts trade off:
+//
+//   generation  Chunk constructor, columns of setBlock
+//   meshing     Chunk::buildMesh, row copies into the snapshot
+//   raycast     World::raycast through loaded terrain, scattered getBlock
+//   lighting    skylight column scans, then a flood fill reading 3D neighborhoods
+//
+//   layout_benchmark_<layout> [--iterations N] [--json FILE]
+
+#include "Bench.h"
+#include "Chunk.h"
+#include "World.h"
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int CHUNKS = 16;
+    constexpr int RAYS = 5000;
+    constexpr size_t BLOCKS_PER_CHUNK = size_t(Chunk::WIDTH) * Chunk::HEIGHT * Chunk::DEPTH;
+
+    struct Result {
+        std::string workload;
+        size_t operations = 0; // Per iteration: blocks, or rays for raycast
+        size_t checksum = 0;   // Keeps the work from being optimized away, and equal across layouts
+        double seconds = 0.0;  // Total over all iterations
+    };
+
+    Result generation(int iterations) {
+        Result result{"generation", CHUNKS * BLOCKS_PER_CHUNK};
+        for (int i = 0; i < iterations; ++i) {
+            std::vector<Chunk> chunks;
+            chunks.reserve(CHUNKS);
+            result.seconds += Bench::timed([&] {
+                for (int c = 0; c < CHUNKS; ++c) chunks.emplace_back(Bench::chunkPosition(c));
+            });
+            for (const Chunk& chunk : chunks) result.checksum += chunk.getBlock(5, 40, 7);
+        }
+        return result;
+    }
+
+    Result meshing(const World& world, std::vector<Chunk>& chunks, int iterations) {
+        Result result{"meshing", chunks.size() * BLOCKS_PER_CHUNK};
+        for (int i = 0; i < iterations; ++i) {
+            for (Chunk& chunk : chunks) chunk.markDirty();
+            result.seconds += Bench::timed([&] {
+                for (Chunk& chunk : chunks) chunk.buildMesh(world, MeshMode::Greedy, MeshFormat::Vertices);
+            });
+        }
+        for (const Chunk& chunk : chunks) result.checksum += chunk.quadCount();
+        return result;
+    }
+
+    // Rays from above the terrain around the loaded area's center, mostly downward.
+    // Uses raw mt19937 output, which is the same on every platform.
+    Result raycast(World& world, int iterations) {
+        std::vector<std::pair<glm::vec3, glm::vec3>> rays;
+        std::mt19937 rng(42);
+        for (int i = 0; i < RAYS; ++i) {
+            glm::vec3 start(float(rng() % 6400) / 100.0f - 24.0f, 100.0f + float(rng() % 2000) / 100.0f,
+                            float(rng() % 6400) / 100.0f - 24.0f);
+            glm::vec3 direction(float(rng() % 200) - 100.0f, -float(rng() % 100) - 20.0f, float(rng() % 200) - 100.0f);
+            rays.emplace_back(start, direction);
+        }
+
+        Result result{"raycast", RAYS};
+        for (int i = 0; i < iterations; ++i) {
+            size_t hits = 0;
+            result.seconds += Bench::timed([&] {
+                for (const auto& [start, direction] : rays) {
+                    if (auto hit = world.raycast(start, direction, 96.0f)) hits += hit->blockPos.y;
+                }
+            });
+            result.checksum = hits;
+        }
+        return result;
+    }
+
+    // Sky light 15 down each column to the first block, then spread through air
+    // losing one level per step, the way a lighting engine would
+    size_t light(const Chunk& chunk, std::vector<uint8_t>& levels, std::vector<int>& queue) {
+        auto cell = [](int x, int y, int z) { return x + z * Chunk::WIDTH + y * Chunk::WIDTH * Chunk::DEPTH; };
+        std::fill(levels.begin(), levels.end(), 0);
+        queue.clear();
+        for (int z = 0; z < Chunk::DEPTH; ++z) {
+            for (int x = 0; x < Chunk::WIDTH; ++x) {
+                for (int y = Chunk::HEIGHT - 1; y >= 0 && chunk.getBlock(x, y, z) == 0; --y) {
+                    levels[cell(x, y, z)] = 15;
+                    queue.push_back(cell(x, y, z));
+                }
+            }
+        }
+
+        static const int STEPS[6][3] = {{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
+        for (size_t head = 0; head < queue.size(); ++head) {
+            int i = queue[head];
+            int x = i % Chunk::WIDTH, z = i / Chunk::WIDTH % Chunk::DEPTH, y = i / (Chunk::WIDTH * Chunk::DEPTH);
+            uint8_t next = levels[i] - 1;
+            if (next == 0) continue;
+            for (const auto& step : STEPS) {
+                int nx = x + step[0], ny = y + step[1], nz = z + step[2];
+                if (nx < 0 || nx >= Chunk::WIDTH || ny < 0 || ny >= Chunk::HEIGHT || nz < 0 || nz >= Chunk::DEPTH) continue;
+                int n = cell(nx, ny, nz);
+                if (levels[n] >= next || chunk.getBlock(nx, ny, nz) != 0) continue;
+                levels[n] = next;
+                queue.push_back(n);
+            }
+        }
+
+        size_t total = 0;
+        for (uint8_t level : levels) total += level;
+        return total;
+    }
+
+    Result lighting(const std::vector<Chunk>& chunks, int iterations) {
+        Result result{"lighting", chunks.size() * BLOCKS_PER_CHUNK};
+        std::vector<uint8_t> levels(BLOCKS_PER_CHUNK);
+        std::vector<int> queue;
+        for (int i = 0; i < iterations; ++i) {
+            size_t total = 0;
+            result.seconds += Bench::timed([&] {
+                for (const Chunk& chunk : chunks) total += light(chunk, levels, queue);
+            });
+            result.checksum = total;
+        }
+        return result;
+    }
+
+    double nsPerOperation(const Result& r, int iterations) { return r.seconds * 1e9 / (double(r.operations) * iterations); }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results, int iterations) {
+        out << std::fixed << "{\n";
+        out << "  \"layout\": \"" << Layout::name(Layout::SELECTED) << "\",\n";
+        out << "  \"iterations\": " << iterations << ",\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << "    {\"workload\": \"" << r.workload << "\", \"operations\": " << r.operations << ", "
+                << std::setprecision(3) << "\"ns_per_op\": " << nsPerOperation(r, iterations) << ", "
+                << "\"ms_total\": " << r.seconds * 1e3 << ", \"checksum\": " << r.checksum << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    std::optional<Bench::Options> options = Bench::parseOptions(argc, argv, 10);
+    if (!options) return 1;
+    const int iterations = options->iterations;
+
+    // Loads the terrain around the origin that the rays are cast into; its chunks are
+    // never neighbors of the benchmark's own
+    World world;
+    world.update(glm::vec3(8.0f, 100.0f, 8.0f), glm::vec3(0.0f, 0.0f, -1.0f), 3);
+
+    std::vector<Chunk> chunks;
+    chunks.reserve(CHUNKS);
+    for (int c = 0; c < CHUNKS; ++c) chunks.emplace_back(Bench::chunkPosition(c));
+
+    std::vector<Result> results;
+    results.push_back(generation(iterations));
+    results.push_back(meshing(world, chunks, iterations));
+    results.push_back(raycast(world, iterations));
+    results.push_back(lighting(chunks, iterations));
+
+    std::cout << "layout " << Layout::name(Layout::SELECTED) << "\n";
+    std::cout << std::left << std::setw(14) << "workload" << std::right << std::setw(12) << "ns/op"
+              << std::setw(14) << "ms total" << std::setw(14) << "checksum" << "\n";
+    for (const Result& r : results) {
+        std::cout << std::left << std::setw(14) << r.workload << std::right << std::fixed
+                  << std::setprecision(3) << std::setw(12) << nsPerOperation(r, iterations)
+                  << std::setprecision(1) << std::setw(14) << r.seconds * 1e3
+                  << std::setw(14) << r.checksum << "\n";
+    }
+
+    bool written = Bench::writeJson(*options, [&](std::ostream& file) { writeJson(file, results, iterations); });
+    return written ? 0 : 1;
+}
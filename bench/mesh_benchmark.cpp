@@ -0,0 +1,185 @@
+// Headless meshing benchmark. Builds deterministic chunk sets and times
+// Chunk::buildMesh for every mesh mode and format without a window or GL context.
+//
+//   mesh_benchmark [--iterations N] [--json FILE]
+//
+// Results go to stdout as a table, and to FILE as JSON when given, so runs can
+// be diffed between releases.
+
+#include "Bench.h"
+#include "Chunk.h"
+#include "World.h"
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr int CHUNKS_PER_SET = 16;
+    constexpr size_t BLOCKS_PER_CHUNK = size_t(Chunk::WIDTH) * Chunk::HEIGHT * Chunk::DEPTH;
+
+    struct ChunkSet {
+        std::string name;
+        std::vector<Chunk> chunks;
+    };
+
+    struct Result {
+        std::string set;
+        std::string mode;
+        std::string format;
+        size_t chunks = 0;
+        size_t faces = 0;     // Quads per pass
+        size_t bytes = 0;     // Mesh bytes per pass
+        double seconds = 0.0; // Total over all iterations
+    };
+
+    void fill(Chunk& chunk, BlockId block) {
+        for (BlockStorage& section : chunk.blocks) section.fill(block);
+    }
+
+    ChunkSet makeFlat() {
+        ChunkSet set{"flat", {}};
+        set.chunks.reserve(CHUNKS_PER_SET);
+        for (int i = 0; i < CHUNKS_PER_SET; ++i) {
+            Chunk& chunk = set.chunks.emplace_back(Bench::chunkPosition(i));
+            fill(chunk, 0);
+            for (int y = 0; y < Chunk::HEIGHT / 2; ++y)
+                for (int z = 0; z < Chunk::DEPTH; ++z)
+                    for (int x = 0; x < Chunk::WIDTH; ++x) chunk.setBlock(x, y, z, 1, false);
+        }
+        return set;
+    }
+
+    // The game's own terrain
+    ChunkSet makeNoise() {
+        ChunkSet set{"noise", {}};
+        set.chunks.reserve(CHUNKS_PER_SET);
+        for (int i = 0; i < CHUNKS_PER_SET; ++i) set.chunks.emplace_back(Bench::chunkPosition(i));
+        return set;
+    }
+
+    // Every other block solid: the most faces a chunk can have and nothing to merge
+    ChunkSet makeCheckerboard() {
+        ChunkSet set{"checkerboard", {}};
+        set.chunks.reserve(CHUNKS_PER_SET);
+        for (int i = 0; i < CHUNKS_PER_SET; ++i) {
+            Chunk& chunk = set.chunks.emplace_back(Bench::chunkPosition(i));
+            for (int y = 0; y < Chunk::HEIGHT; ++y)
+                for (int z = 0; z < Chunk::DEPTH; ++z)
+                    for (int x = 0; x < Chunk::WIDTH; ++x) chunk.setBlock(x, y, z, (x + y + z) % 2 ? 0 : 1, false);
+        }
+        return set;
+    }
+
+    // Solid ground below y = 96 with random-walk tunnels carved through it. Uses
+    // raw mt19937 output, which is the same on every platform, unlike the distributions.
+    ChunkSet makeCaves() {
+        ChunkSet set{"caves", {}};
+        set.chunks.reserve(CHUNKS_PER_SET);
+        for (int i = 0; i < CHUNKS_PER_SET; ++i) {
+            Chunk& chunk = set.chunks.emplace_back(Bench::chunkPosition(i));
+            fill(chunk, 0);
+            for (int y = 0; y < 96; ++y)
+                for (int z = 0; z < Chunk::DEPTH; ++z)
+                    for (int x = 0; x < Chunk::WIDTH; ++x) chunk.setBlock(x, y, z, y < 48 ? 2 : 1, false);
+
+            std::mt19937 rng(1234 + i);
+            for (int tunnel = 0; tunnel < 6; ++tunnel) {
+                glm::ivec3 p(rng() % Chunk::WIDTH, 8 + rng() % 80, rng() % Chunk::DEPTH);
+                for (int step = 0; step < 40; ++step) {
+                    for (int dy = -2; dy <= 2; ++dy)
+                        for (int dz = -2; dz <= 2; ++dz)
+                            for (int dx = -2; dx <= 2; ++dx) {
+                                if (dx * dx + dy * dy + dz * dz > 5) continue;
+                                chunk.setBlock(p.x + dx, p.y + dy, p.z + dz, 0, false);
+                            }
+                    p += glm::ivec3(int(rng() % 3) - 1, int(rng() % 3) - 1, int(rng() % 3) - 1);
+                }
+            }
+        }
+        return set;
+    }
+
+    Result run(const World& world, ChunkSet& set, MeshMode mode, MeshFormat format, int iterations) {
+        Result result;
+        result.set = set.name;
+        result.mode = mode == MeshMode::Greedy ? "greedy" : "per_face";
+        result.format = format == MeshFormat::Faces ? "faces" : "vertices";
+        result.chunks = set.chunks.size();
+
+        for (int i = 0; i < iterations; ++i) {
+            for (Chunk& chunk : set.chunks) chunk.markDirty();
+            result.seconds += Bench::timed([&] {
+                for (Chunk& chunk : set.chunks) chunk.buildMesh(world, mode, format);
+            });
+        }
+        for (const Chunk& chunk : set.chunks) {
+            result.faces += chunk.quadCount();
+            result.bytes += chunk.meshBytes();
+        }
+        return result;
+    }
+
+    double facesPerSecond(const Result& r, int iterations) { return r.faces * iterations / r.seconds; }
+    double bytesPerChunk(const Result& r) { return double(r.bytes) / r.chunks; }
+    double nsPerBlock(const Result& r, int iterations) { return r.seconds * 1e9 / (double(r.chunks) * iterations * BLOCKS_PER_CHUNK); }
+
+    void writeJson(std::ostream& out, const std::vector<Result>& results, int iterations) {
+        out << std::fixed << "{\n";
+        out << "  \"iterations\": " << iterations << ",\n";
+        out << "  \"chunks_per_set\": " << CHUNKS_PER_SET << ",\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << "    {\"set\": \"" << r.set << "\", \"mode\": \"" << r.mode << "\", \"format\": \"" << r.format << "\", "
+                << "\"faces_per_chunk\": " << r.faces / r.chunks << ", "
+                << std::setprecision(0) << "\"faces_per_sec\": " << facesPerSecond(r, iterations) << ", "
+                << std::setprecision(1) << "\"bytes_per_chunk\": " << bytesPerChunk(r) << ", "
+                << std::setprecision(3) << "\"ns_per_block\": " << nsPerBlock(r, iterations) << ", "
+                << "\"ms_per_chunk\": " << r.seconds * 1e3 / (double(r.chunks) * iterations) << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    std::optional<Bench::Options> options = Bench::parseOptions(argc, argv, 20);
+    if (!options) return 1;
+    const int iterations = options->iterations;
+
+    // Only used for neighbor lookups, which find nothing, so chunk borders read as air
+    World world;
+
+    std::vector<ChunkSet> sets;
+    sets.push_back(makeFlat());
+    sets.push_back(makeNoise());
+    sets.push_back(makeCheckerboard());
+    sets.push_back(makeCaves());
+
+    std::vector<Result> results;
+    for (ChunkSet& set : sets) {
+        for (MeshMode mode : {MeshMode::PerFace, MeshMode::Greedy}) {
+            for (MeshFormat format : {MeshFormat::Vertices, MeshFormat::Faces}) {
+                results.push_back(run(world, set, mode, format, iterations));
+            }
+        }
+    }
+
+    std::cout << std::left << std::setw(14) << "set" << std::setw(10) << "mode" << std::setw(10) << "format"
+              << std::right << std::setw(12) << "faces/chunk" << std::setw(14) << "Mfaces/s"
+              << std::setw(14) << "bytes/chunk" << std::setw(12) << "ns/block" << "\n";
+    for (const Result& r : results) {
+        std::cout << std::left << std::setw(14) << r.set << std::setw(10) << r.mode << std::setw(10) << r.format
+                  << std::right << std::fixed << std::setw(12) << r.faces / r.chunks
+                  << std::setprecision(2) << std::setw(14) << facesPerSecond(r, iterations) / 1e6
+                  << std::setprecision(0) << std::setw(14) << bytesPerChunk(r)
+                  << std::setprecision(3) << std::setw(12) << nsPerBlock(r, iterations) << "\n";
+    }
+
+    bool written = Bench::writeJson(*options, [&](std::ostream& file) { writeJson(file, results, iterations); });
+    return written ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Order of the blocks of a 16x16x16 chunk section in BlockStorage, picked at
+// compile time with BLOCK_LAYOUT (a CMake cache variable). layout_benchmark is
+// built once per layout to compare them.
+enum class BlockLayout {
+    YMajor,      // x fastest, then z, then y: horizontal slices are contiguous
+    ColumnMajor, // y fastest: columns are contiguous, for heightmap and skylight scans
+    Morton       // x, z, y bits interleaved: 2x2x2 and 4x4x4 bricks are contiguous
+};
+
+#ifndef BLOCK_LAYOUT
+#define BLOCK_LAYOUT YMajor
+#endif
+
+namespace Layout {
+    constexpr BlockLayout SELECTED = BlockLayout::BLOCK_LAYOUT;
+
+    // Moves the 4 low bits of v to bits 0, 3, 6 and 9
+    constexpr int spread(int v) { return (v & 1) | (v & 2) << 2 | (v & 4) << 4 | (v & 8) << 6; }
+
+    // Section-local coordinates, each 0..15
+    template <BlockLayout L>
+    constexpr int index(int x, int y, int z) {
+        if constexpr (L == BlockLayout::YMajor) return x + z * 16 + y * 256;
+        else if constexpr (L == BlockLayout::ColumnMajor) return y + x * 16 + z * 256;
+        else return spread(x) | spread(z) << 1 | spread(y) << 2;
+    }
+
+    constexpr const char* name(BlockLayout layout) {
+        return layout == BlockLayout::YMajor ? "y_major" : layout == BlockLayout::ColumnMajor ? "column_major" : "morton";
+    }
+}
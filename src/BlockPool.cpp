@@ -0,0 +1,87 @@
+#include "BlockPool.h"
+#include <bit>
+#include <mutex>
+#include <new>
+#include <vector>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct SizeClass {
+        FreeBlock* free = nullptr; // Intrusive list through the released blocks themselves
+        char* carve = nullptr;     // Not yet handed out part of the newest slab
+        char* carveEnd = nullptr;
+        size_t inUse = 0;
+        size_t freeCount = 0;
+    };
+
+    struct Pool {
+        std::mutex mutex;
+        std::array<SizeClass, BlockPool::CLASSES> classes;
+        std::vector<void*> slabs;
+
+        ~Pool() {
+            for (void* slab : slabs) ::operator delete(slab, std::align_val_t(BlockPool::SLAB_BYTES));
+        }
+    };
+
+    Pool& pool() {
+        static Pool instance;
+        return instance;
+    }
+
+    int classIndex(int bits) { return std::countr_zero(static_cast<unsigned>(bits)); }
+}
+
+void* BlockPool::allocate(int bits) {
+    Pool& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    SizeClass& sizeClass = p.classes[classIndex(bits)];
+    sizeClass.inUse++;
+    if (FreeBlock* block = sizeClass.free) {
+        sizeClass.free = block->next;
+        sizeClass.freeCount--;
+        return block;
+    }
+
+    const size_t bytes = classBytes(bits);
+    if (size_t(sizeClass.carveEnd - sizeClass.carve) < bytes) {
+        void* slab = ::operator new(SLAB_BYTES, std::align_val_t(SLAB_BYTES));
+#ifdef __linux__
+        madvise(slab, SLAB_BYTES, MADV_HUGEPAGE);
+#endif
+        p.slabs.push_back(slab);
+        sizeClass.carve = static_cast<char*>(slab);
+        sizeClass.carveEnd = sizeClass.carve + SLAB_BYTES;
+    }
+    void* block = sizeClass.carve;
+    sizeClass.carve += bytes;
+    return block;
+}
+
+void BlockPool::release(void* block, int bits) {
+    Pool& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    SizeClass& sizeClass = p.classes[classIndex(bits)];
+    sizeClass.free = new (block) FreeBlock{sizeClass.free};
+    sizeClass.inUse--;
+    sizeClass.freeCount++;
+}
+
+BlockPoolStats BlockPool::stats() {
+    Pool& p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    BlockPoolStats stats;
+    stats.slabs = p.slabs.size();
+    stats.reservedBytes = p.slabs.size() * SLAB_BYTES;
+    for (const SizeClass& sizeClass : p.classes) {
+        stats.blocksInUse += sizeClass.inUse;
+        stats.blocksFree += sizeClass.freeCount;
+    }
+    return stats;
+}
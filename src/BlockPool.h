@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct BlockPoolStats {
+    size_t slabs = 0;
+    size_t reservedBytes = 0;
+    size_t blocksInUse = 0;
+    size_t blocksFree = 0;
+};
+
+// Fixed-size memory blocks for BlockStorage, one size class per packed format
+// (1, 2, 4, 8 and 16 bits per block). Blocks are carved out of slabs aligned to
+// their own size, which on Linux are advised to use transparent huge pages. A
+// released block goes onto its class's free list for the next section that
+// needs one, so streaming chunks in and out does not touch the heap once the
+// slabs are warm. Slabs are kept for the life of the program.
+class BlockPool {
+public:
+    static constexpr size_t SLAB_BYTES = 2 * 1024 * 1024;
+    static constexpr int CLASSES = 5;
+
+    // Words of the packed format plus its largest palette and the palette's use
+    // counts, rounded to cache lines
+    static constexpr size_t classBytes(int bits) {
+        size_t words = size_t(16 * 16 * 16) * bits / 8;
+        size_t palette = bits < 16 ? (size_t(1) << bits) * 2 * sizeof(uint16_t) : 0;
+        return (words + palette + 63) / 64 * 64;
+    }
+
+    static void* allocate(int bits);
+    static void release(void* block, int bits);
+    static BlockPoolStats stats();
+};
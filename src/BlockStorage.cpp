@@ -0,0 +1,111 @@
+#include "BlockStorage.h"
+#include <cstring>
+#include <utility>
+
+BlockStorage::BlockStorage(BlockStorage&& other) noexcept {
+    *this = std::move(other);
+}
+
+BlockStorage& BlockStorage::operator=(BlockStorage&& other) noexcept {
+    if (this == &other) return *this;
+    if (words) BlockPool::release(words, bits);
+    words = std::exchange(other.words, nullptr);
+    single = other.single;
+    paletteSize = std::exchange(other.paletteSize, 1);
+    bits = std::exchange(other.bits, 0);
+    wordShift = std::exchange(other.wordShift, 0);
+    wordMask = std::exchange(other.wordMask, 0);
+    valueMask = std::exchange(other.valueMask, 0);
+    return *this;
+}
+
+BlockStorage::~BlockStorage() {
+    if (words) BlockPool::release(words, bits);
+}
+
+void BlockStorage::set(int index, BlockId id) {
+    if (bits == 0) {
+        if (id == single) return;
+        repack(1);
+    }
+    if (bits == DIRECT_BITS) {
+        store(index, id);
+        return;
+    }
+    int entry = find(id);
+    if (entry < 0) {
+        if (paletteSize == 1u << bits && (entry = unusedEntry()) < 0) {
+            repack(bits == 8 ? DIRECT_BITS : bits * 2);
+            if (bits == DIRECT_BITS) {
+                store(index, id);
+                return;
+            }
+        }
+        if (entry < 0) {
+            entry = paletteSize++;
+            uses()[entry] = 0;
+        }
+        palette()[entry] = id;
+    }
+    write(index, static_cast<uint32_t>(entry));
+
+    // Every block holds this id again
+    if (uses()[entry] == SIZE) fill(id);
+}
+
+void BlockStorage::fill(BlockId id) {
+    *this = BlockStorage();
+    single = id;
+}
+
+void BlockStorage::copy(int index, int count, uint8_t* out) const {
+    if (bits == 0) {
+        std::memset(out, Blocks::renderId(single), count);
+        return;
+    }
+    for (int i = 0; i < count; ++i) out[i] = Blocks::renderId(get(index + i));
+}
+
+// Palettes hold at most 256 ids, so a scan is bounded and usually 2 or 3 long
+int BlockStorage::find(BlockId id) const {
+    const BlockId* ids = palette();
+    for (int i = 0; i < paletteSize; ++i) {
+        if (ids[i] == id) return i;
+    }
+    return -1;
+}
+
+int BlockStorage::unusedEntry() const {
+    const uint16_t* counts = uses();
+    for (int i = 0; i < paletteSize; ++i) {
+        if (counts[i] == 0) return i;
+    }
+    return -1;
+}
+
+// Palette indices carry over unchanged, so only the word layout differs
+void BlockStorage::repack(int newBits) {
+    BlockStorage next;
+    next.words = static_cast<uint64_t*>(BlockPool::allocate(newBits));
+    next.single = single;
+    next.bits = newBits;
+    while ((1 << next.wordShift) * newBits < 64) next.wordShift++;
+    next.wordMask = (1 << next.wordShift) - 1;
+    next.valueMask = (1u << newBits) - 1;
+
+    if (newBits == DIRECT_BITS) {
+        for (int i = 0; i < SIZE; ++i) next.store(i, get(i));
+        next.paletteSize = 0;
+    } else {
+        for (int i = 0; i < SIZE; ++i) next.store(i, bits == 0 ? 0 : value(i));
+        if (bits == 0) {
+            next.palette()[0] = single;
+            next.uses()[0] = SIZE;
+        } else {
+            std::memcpy(next.palette(), palette(), paletteSize * sizeof(BlockId));
+            std::memcpy(next.uses(), uses(), paletteSize * sizeof(uint16_t));
+        }
+        next.paletteSize = paletteSize;
+    }
+    *this = std::move(next);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "BlockPool.h"
+#include "Blocks.h"
+
+// Block ids of one 16x16x16 chunk section. Blocks are stored as indices into a
+// palette of the ids the section holds, bit-packed at 0, 1, 2, 4 or 8 bits each
+// depending on the palette size, so a section of a single id needs no index words
+// at all. Past 256 distinct ids the section stores the ids themselves at 16 bits.
+// Widths are powers of two, so no block straddles two words. Each palette entry
+// counts the blocks using it, so a section returns to uniform as soon as one id
+// covers it and a full palette reuses entries no block uses anymore. The words,
+// the palette and the counts share one BlockPool block sized for the format.
+class BlockStorage {
+public:
+    static constexpr int SIZE = 16 * 16 * 16;
+
+    BlockStorage() = default;
+    BlockStorage(BlockStorage&& other) noexcept;
+    BlockStorage& operator=(BlockStorage&& other) noexcept;
+    BlockStorage(const BlockStorage&) = delete;
+    BlockStorage& operator=(const BlockStorage&) = delete;
+    ~BlockStorage();
+
+    BlockId get(int index) const {
+        if (bits == 0) return single;
+        return bits == DIRECT_BITS ? static_cast<BlockId>(value(index)) : palette()[value(index)];
+    }
+    // Switches to the next wider format when the id is new and the palette is full
+    void set(int index, BlockId id);
+    void fill(BlockId id);
+    // Decodes `count` consecutive blocks starting at `index` as 8-bit render ids
+    void copy(int index, int count, uint8_t* out) const;
+
+    // Every block holds the same id, stored without any index words
+    bool uniform() const { return bits == 0; }
+    int bitsPerBlock() const { return bits; }
+    // Pool memory, not counting the object itself
+    size_t bytes() const { return bits == 0 ? 0 : BlockPool::classBytes(bits); }
+
+private:
+    static constexpr int DIRECT_BITS = 16;
+
+    uint64_t* words = nullptr; // Null while uniform
+    BlockId single = 0;        // The id of a uniform section
+    uint16_t paletteSize = 1;
+    int bits = 0;
+    int wordShift = 0;         // log2 of blocks per word
+    int wordMask = 0;          // Blocks per word - 1
+    uint32_t valueMask = 0;
+
+    BlockId* palette() const { return reinterpret_cast<BlockId*>(words + SIZE * bits / 64); }
+    // Blocks per palette entry, after the largest palette of the format
+    uint16_t* uses() const { return palette() + (1 << bits); }
+    // Palette index, or the id itself at DIRECT_BITS
+    uint32_t value(int index) const {
+        return static_cast<uint32_t>(words[index >> wordShift] >> ((index & wordMask) * bits)) & valueMask;
+    }
+    void store(int index, uint32_t packed) {
+        uint64_t& word = words[index >> wordShift];
+        int shift = (index & wordMask) * bits;
+        word = (word & ~(uint64_t(valueMask) << shift)) | uint64_t(packed) << shift;
+    }
+    // Stores a palette index, moving one use from the block's old entry to it
+    void write(int index, uint32_t entry) {
+        uint16_t* counts = uses();
+        counts[value(index)]--;
+        counts[entry]++;
+        store(index, entry);
+    }
+    int find(BlockId id) const;
+    // A palette entry no block uses anymore, or -1
+    int unusedEntry() const;
+    void repack(int newBits);
+};
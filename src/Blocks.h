@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// One layer of the block texture array, built by loadBlockTextures in main.cpp
+struct BlockTexture {
+    const char* path;
+    uint32_t tint; // 0xRRGGBB scaled by the image's brightness, or 0 to keep its colors
+    bool cutout;   // Only a border stays opaque, so the inside is discarded when drawn
+};
+
+// Stored in chunks; the registry, meshes and snapshots use 8-bit render ids (see Blocks::renderId)
+using BlockId = uint16_t;
+
+struct BlockType {
+    const char* name;
+    bool opaque;      // Hides every neighbor face behind it
+    bool selfCulling; // Hides neighbor faces of the same type, for see-through blocks like glass
+    uint8_t emission; // Light level 0..15; emissive faces skip directional shading
+    std::array<uint8_t, 6> layers; // Texture layer per face, Top, Bottom, Right, Left, Front, Back
+};
+
+// Block registry indexed by the block id stored in chunks. Ids without a type
+// behave as air. The mesher's culling reads the flat tables below instead of
+// the types, so deciding a face is a few table lookups without branches.
+namespace Blocks {
+    enum Id : uint8_t { Air, Stone, Dirt, Grass, Brick, Glass, Lamp, COUNT };
+
+    enum Layer : uint8_t { StoneLayer, DirtLayer, GrassTopLayer, GrassSideLayer, BrickLayer, GlassLayer, LampLayer, LAYERS };
+
+    constexpr BlockTexture TEXTURES[LAYERS] = {
+        {"assets/brick.jpg", 0x8C8C8C, false}, // Stone
+        {"assets/brick.jpg", 0x7A5535, false}, // Dirt
+        {"assets/brick.jpg", 0x5E9A3A, false}, // Grass top
+        {"assets/brick.jpg", 0x6E7A40, false}, // Grass side
+        {"assets/brick.jpg", 0, false},        // Brick
+        {"assets/brick.jpg", 0xC8E6F0, true},  // Glass
+        {"assets/brick.jpg", 0xFFE08A, false}, // Lamp
+    };
+
+    constexpr std::array<uint8_t, 6> sameLayers(uint8_t layer) { return {layer, layer, layer, layer, layer, layer}; }
+
+    constexpr BlockType TYPES[COUNT] = {
+        {"Air", false, false, 0, sameLayers(0)},
+        {"Stone", true, false, 0, sameLayers(StoneLayer)},
+        {"Dirt", true, false, 0, sameLayers(DirtLayer)},
+        {"Grass", true, false, 0, {GrassTopLayer, DirtLayer, GrassSideLayer, GrassSideLayer, GrassSideLayer, GrassSideLayer}},
+        {"Brick", true, false, 0, sameLayers(BrickLayer)},
+        {"Glass", false, true, 0, sameLayers(GlassLayer)},
+        {"Lamp", true, false, 15, sameLayers(LampLayer)},
+    };
+
+    template <typename F>
+    constexpr std::array<uint8_t, 256> makeTable(F property) {
+        std::array<uint8_t, 256> table{};
+        for (int id = 1; id < COUNT; ++id) table[id] = static_cast<uint8_t>(property(TYPES[id]));
+        return table;
+    }
+
+    // 1 or 0 per id
+    constexpr std::array<uint8_t, 256> DRAWN = makeTable([](const BlockType&) { return 1; });
+    constexpr std::array<uint8_t, 256> OPAQUE = makeTable([](const BlockType& type) { return type.opaque; });
+    constexpr std::array<uint8_t, 256> SELF_CULLING = makeTable([](const BlockType& type) { return type.selfCulling; });
+    constexpr std::array<uint8_t, 256> EMISSION = makeTable([](const BlockType& type) { return type.emission; });
+
+    // The id meshing, culling and patching see. Ids without a type render as air,
+    // which also keeps stored ids past 255 out of the 8-bit mesh formats.
+    constexpr uint8_t renderId(BlockId id) { return static_cast<uint8_t>(id < COUNT ? id : BlockId(Air)); }
+
+    // Whether the face of `block` toward `neighbor` is drawn
+    constexpr bool faceVisible(uint8_t block, uint8_t neighbor) {
+        return DRAWN[block] & ~OPAQUE[neighbor] & ~(SELF_CULLING[block] & (block == neighbor));
+    }
+}
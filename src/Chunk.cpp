@@ -1,104 +1,227 @@
 #include "Chunk.h"
 #include "Noise.h"
-#include <GL/glew.h>
+#include "Blocks.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
 #include "World.h"
+#include "ChunkSnapshot.h"
+#include "ChunkMesher.h"
+#include "FaceMasks.h"
 
-Chunk::Chunk(glm::ivec3 pos) : position(pos), blocks(WIDTH * HEIGHT * DEPTH, 0), meshDirty(true) {
-    for (int x = 0; x < WIDTH; ++x) {
-        for (int z = 0; z < DEPTH; ++z) {
+Chunk::Chunk(glm::ivec3 pos) : position(pos), meshDirty(true) {
+    std::array<int, WIDTH * DEPTH> tops;
+    int lowest = HEIGHT, highest = -1;
+    for (int z = 0; z < DEPTH; ++z) {
+        for (int x = 0; x < WIDTH; ++x) {
             float height = Noise::generate(position.x * WIDTH + x, position.z * DEPTH + z) * HEIGHT;
-            for (int y = 0; y < height; ++y) {
-                blocks[x + z * WIDTH + y * WIDTH * DEPTH] = 1; // 1 for solid block
+            int top = static_cast<int>(std::ceil(height)) - 1;
+            tops[x + z * WIDTH] = top;
+            lowest = std::min(lowest, top);
+            highest = std::max(highest, top);
+        }
+    }
+
+    // Sections entirely above every column stay air and those below the dirt of
+    // every column are filled with stone in one go
+    for (int section = 0; section < SECTIONS; ++section) {
+        int yBegin = section * SECTION_HEIGHT, yEnd = yBegin + SECTION_HEIGHT;
+        if (yBegin > highest) continue;
+        if (yEnd - 1 <= lowest - 4) {
+            blocks[section].fill(Blocks::Stone);
+            continue;
+        }
+        for (int z = 0; z < DEPTH; ++z) {
+            for (int x = 0; x < WIDTH; ++x) {
+                int top = tops[x + z * WIDTH];
+                for (int y = yBegin; y < std::min(yEnd, top + 1); ++y) {
+                    setBlock(x, y, z, y == top ? Blocks::Grass : y > top - 4 ? Blocks::Dirt : Blocks::Stone, false);
+                }
             }
         }
     }
 }
 
-uint8_t Chunk::getBlock(int x, int y, int z) const {
+BlockId Chunk::getBlock(int x, int y, int z) const {
     if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT || z < 0 || z >= DEPTH) {
         return 0; // Air block
     }
-    return blocks[x + z * WIDTH + y * WIDTH * DEPTH];
+    return blocks[y / SECTION_HEIGHT].get(index(x, y % SECTION_HEIGHT, z));
 }
 
-void Chunk::setBlock(int x, int y, int z, uint8_t block) {
+void Chunk::setBlock(int x, int y, int z, BlockId block, bool remesh) {
     if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT || z < 0 || z >= DEPTH) {
         return;
     }
-    blocks[x + z * WIDTH + y * WIDTH * DEPTH] = block;
+    blocks[y / SECTION_HEIGHT].set(index(x, y % SECTION_HEIGHT, z), block);
+
+    // Removing the top block lowers the surface to the next block down, skipping air sections whole
+    uint8_t& top = surface[x + z * WIDTH];
+    if (block != 0 && y >= top) {
+        top = static_cast<uint8_t>(y + 1);
+    } else if (block == 0 && y + 1 == top) {
+        while (top > 0 && getBlock(x, top - 1, z) == 0) {
+            int section = (top - 1) / SECTION_HEIGHT;
+            top = static_cast<uint8_t>(uniformBlock(section) == 0 ? section * SECTION_HEIGHT : top - 1);
+        }
+    }
+    if (!remesh) return;
+
+    // Faces of the blocks above and below belong to the next section over
+    int section = y / SECTION_HEIGHT;
+    markSectionDirty(section);
+    sections[section].interactive = true;
+    if (y % SECTION_HEIGHT == 0 && section > 0) {
+        markSectionDirty(section - 1);
+        sections[section - 1].interactive = true;
+    }
+    if (y % SECTION_HEIGHT == SECTION_HEIGHT - 1 && section + 1 < SECTIONS) {
+        markSectionDirty(section + 1);
+        sections[section + 1].interactive = true;
+    }
+}
+
+void Chunk::copyRow(int y, int z, uint8_t* out) const {
+    const BlockStorage& section = blocks[y / SECTION_HEIGHT];
+    if constexpr (Layout::SELECTED == BlockLayout::YMajor) {
+        section.copy(index(0, y % SECTION_HEIGHT, z), WIDTH, out);
+    } else {
+        for (int x = 0; x < WIDTH; ++x) out[x] = Blocks::renderId(section.get(index(x, y % SECTION_HEIGHT, z)));
+    }
+}
+
+void Chunk::markDirty() {
+    for (Section& section : sections) section.dirty = true;
     meshDirty = true;
+    version++;
 }
 
-void Chunk::buildMesh(const World& world) {
-    vertices.clear();
-    indices.clear();
-    unsigned int indexOffset = 0;
+void Chunk::markSectionDirty(int section) {
+    sections[section].dirty = true;
+    meshDirty = true;
+    version++;
+}
 
-    for (int y = 0; y < HEIGHT; ++y) {
-        for (int z = 0; z < DEPTH; ++z) {
-            for (int x = 0; x < WIDTH; ++x) {
-                if (getBlock(x, y, z) == 0) continue;
+void Chunk::setLod(int level) {
+    if (level == lod) return;
+    lod = static_cast<uint8_t>(level);
+    markDirty();
+}
 
-                // Check for exposed faces
-                if (world.getBlock(glm::ivec3(position.x * WIDTH + x, y + 1, position.z * DEPTH + z)) == 0) { // Top
-                    indices.insert(indices.end(), {indexOffset, indexOffset + 1, indexOffset + 2, indexOffset + 2, indexOffset + 3, indexOffset});
-                    vertices.insert(vertices.end(), {x - 0.5f, y + 0.5f, z - 0.5f, 0, 1, x + 0.5f, y + 0.5f, z - 0.5f, 1, 1, x + 0.5f, y + 0.5f, z + 0.5f, 1, 0, x - 0.5f, y + 0.5f, z + 0.5f, 0, 0});
-                    indexOffset += 4;
-                }
-                if (world.getBlock(glm::ivec3(position.x * WIDTH + x, y - 1, position.z * DEPTH + z)) == 0) { // Bottom
-                    indices.insert(indices.end(), {indexOffset, indexOffset + 1, indexOffset + 2, indexOffset + 2, indexOffset + 3, indexOffset});
-                    vertices.insert(vertices.end(), {x - 0.5f, y - 0.5f, z - 0.5f, 0, 0, x + 0.5f, y - 0.5f, z - 0.5f, 1, 0, x + 0.5f, y - 0.5f, z + 0.5f, 1, 1, x - 0.5f, y - 0.5f, z + 0.5f, 0, 1});
-                    indexOffset += 4;
-                }
-                if (world.getBlock(glm::ivec3(position.x * WIDTH + x + 1, y, position.z * DEPTH + z)) == 0) { // Right
-                    indices.insert(indices.end(), {indexOffset, indexOffset + 1, indexOffset + 2, indexOffset + 2, indexOffset + 3, indexOffset});
-                    vertices.insert(vertices.end(), {x + 0.5f, y - 0.5f, z - 0.5f, 0, 0, x + 0.5f, y + 0.5f, z - 0.5f, 1, 0, x + 0.5f, y + 0.5f, z + 0.5f, 1, 1, x + 0.5f, y - 0.5f, z + 0.5f, 0, 1});
-                    indexOffset += 4;
-                }
-                if (world.getBlock(glm::ivec3(position.x * WIDTH + x - 1, y, position.z * DEPTH + z)) == 0) { // Left
-                    indices.insert(indices.end(), {indexOffset, indexOffset + 1, indexOffset + 2, indexOffset + 2, indexOffset + 3, indexOffset});
-                    vertices.insert(vertices.end(), {x - 0.5f, y - 0.5f, z - 0.5f, 0, 0, x - 0.5f, y + 0.5f, z - 0.5f, 1, 0, x - 0.5f, y + 0.5f, z + 0.5f, 1, 1, x - 0.5f, y - 0.5f, z + 0.5f, 0, 1});
-                    indexOffset += 4;
-                }
-                if (world.getBlock(glm::ivec3(position.x * WIDTH + x, y, position.z * DEPTH + z + 1)) == 0) { // Front
-                    indices.insert(indices.end(), {indexOffset, indexOffset + 1, indexOffset + 2, indexOffset + 2, indexOffset + 3, indexOffset});
-                    vertices.insert(vertices.end(), {x - 0.5f, y - 0.5f, z + 0.5f, 0, 0, x + 0.5f, y - 0.5f, z + 0.5f, 1, 0, x + 0.5f, y + 0.5f, z + 0.5f, 1, 1, x - 0.5f, y + 0.5f, z + 0.5f, 0, 1});
-                    indexOffset += 4;
-                }
-                if (world.getBlock(glm::ivec3(position.x * WIDTH + x, y, position.z * DEPTH + z - 1)) == 0) { // Back
-                    indices.insert(indices.end(), {indexOffset, indexOffset + 1, indexOffset + 2, indexOffset + 2, indexOffset + 3, indexOffset});
-                    vertices.insert(vertices.end(), {x - 0.5f, y - 0.5f, z - 0.5f, 0, 0, x + 0.5f, y - 0.5f, z - 0.5f, 1, 0, x + 0.5f, y + 0.5f, z - 0.5f, 1, 1, x - 0.5f, y + 0.5f, z - 0.5f, 0, 1});
-                    indexOffset += 4;
-                }
-            }
-        }
+uint8_t Chunk::takeDirtySections() {
+    uint8_t dirty = 0;
+    for (int i = 0; i < SECTIONS; ++i) {
+        if (sections[i].dirty) dirty |= 1u << i;
+        sections[i].dirty = false;
     }
+    meshDirty = false;
+    return dirty;
+}
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+uint8_t Chunk::interactiveSections() const {
+    uint8_t interactive = 0;
+    for (int i = 0; i < SECTIONS; ++i) {
+        if (sections[i].interactive) interactive |= 1u << i;
+    }
+    return interactive;
+}
 
-    glBindVertexArray(VAO);
+void Chunk::applySectionMesh(int section, MeshMode mode, MeshFormat format, MeshSpan mesh, const FaceCounts& faceQuads) {
+    sections[section].mode = mode;
+    sections[section].format = format;
+    sections[section].mesh = std::move(mesh);
+    sections[section].faceQuads = faceQuads;
+    // Swapped out rather than assigned {}, which would keep the capacity
+    std::vector<uint32_t>().swap(sections[section].patchMesh);
+    std::vector<uint16_t>().swap(sections[section].faceSlots);
+    std::vector<uint16_t>().swap(sections[section].slotFaces);
+    sections[section].uploadPending = true;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+void Chunk::buildMesh(const World& world, MeshMode mode, MeshFormat format) {
+    auto snapshot = std::make_unique<ChunkSnapshot>();
+    snapshot->capture(world, *this);
+    snapshot->downsample();
+    auto masks = std::make_unique<FaceMasks>();
+    masks->build(*snapshot);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    thread_local ChunkMesher mesher;
+    thread_local MeshArena arena;
+    thread_local std::vector<uint32_t> scratch;
+    uint8_t dirty = takeDirtySections();
+    for (int i = 0; i < SECTIONS; ++i) {
+        if (!(dirty & (1u << i))) continue;
+        MeshMode sectionMode = lod > 0 ? MeshMode::Greedy : sections[i].interactive ? MeshMode::PerFace : mode;
+        FaceCounts faceQuads;
+        mesher.buildSection(*snapshot, *masks, i, sectionMode, format, scratch, faceQuads);
+        applySectionMesh(i, sectionMode, format, arena.store(scratch), faceQuads);
+    }
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+size_t Chunk::uploadSection(int index, GeometryPool& geometry, StreamBuffer& stream) {
+    Section& section = sections[index];
+    section.uploadPending = false;
+    section.gpuFormat = section.format;
+    section.gpuQuads = section.quadCount();
+    section.gpuFaceQuads = section.faceQuads;
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // A fresh mesh comes from the arena; re-uploads of patched sections from their CPU copy
+    const uint32_t* data = section.mesh.empty() ? section.patchMesh.data() : section.mesh.data();
+    size_t words = section.mesh.empty() ? section.patchMesh.size() : section.mesh.size();
+    geometry.upload(section.gpuMesh, position, data, words * sizeof(uint32_t), stream);
 
-    meshDirty = false;
+    if (section.interactive && section.mode == MeshMode::PerFace && !section.mesh.empty())
+        section.patchMesh.assign(data, data + words);
+    section.mesh = {};
+    return words * sizeof(uint32_t);
 }
 
-void Chunk::render() {
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+bool Chunk::canPatch(int index, MeshFormat format) const {
+    const Section& section = sections[index];
+    return !meshing && !section.dirty && !section.uploadPending && section.mode == MeshMode::PerFace &&
+           section.format == format && section.gpuFormat == format &&
+           section.patchMesh.size() == section.quadCount() * (format == MeshFormat::Faces ? 1 : 4);
+}
+
+size_t Chunk::uploadPatch(int index, std::vector<uint32_t>& changedSlots, GeometryPool& geometry, StreamBuffer& stream) {
+    Section& section = sections[index];
+    const size_t wordsPerQuad = section.format == MeshFormat::Faces ? 1 : 4;
+    if (!section.gpuMesh.valid() || section.patchMesh.size() > geometry.capacityWords(section.gpuMesh)) {
+        changedSlots.clear();
+        return uploadSection(index, geometry, stream);
+    }
+
+    // Slots past the end were vacated by removals and only need the smaller draw count
+    size_t quads = section.quadCount();
+    std::sort(changedSlots.begin(), changedSlots.end());
+    size_t bytes = 0;
+    for (size_t i = 0; i < changedSlots.size() && changedSlots[i] < quads;) {
+        size_t begin = changedSlots[i], end = begin + 1;
+        while (++i < changedSlots.size() && changedSlots[i] <= end && changedSlots[i] < quads) end = changedSlots[i] + 1;
+        geometry.update(section.gpuMesh, begin * wordsPerQuad, &section.patchMesh[begin * wordsPerQuad], (end - begin) * wordsPerQuad);
+        bytes += (end - begin) * wordsPerQuad * sizeof(uint32_t);
+    }
+    changedSlots.clear();
+
+    section.gpuQuads = quads;
+    section.gpuFaceQuads = section.faceQuads;
+    return bytes;
+}
+
+size_t Chunk::quadCount() const {
+    size_t total = 0;
+    for (const Section& section : sections) total += section.quadCount();
+    return total;
+}
+
+size_t Chunk::meshBytes() const {
+    size_t total = 0;
+    for (const Section& section : sections) total += (section.mesh.size() + section.patchMesh.size()) * sizeof(uint32_t);
+    return total;
+}
+
+size_t Chunk::blockBytes() const {
+    size_t total = sizeof(blocks);
+    for (const BlockStorage& section : blocks) total += section.bytes();
+    return total;
+}
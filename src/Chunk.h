@@ -1,32 +1,121 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <glm/glm.hpp>
 #include <cstdint>
+#include "BlockLayout.h"
+#include "BlockStorage.h"
+#include "GeometryPool.h"
+#include "MeshArena.h"
 
 class World;
+class StreamBuffer;
+
+enum class MeshMode {
+    PerFace, // One quad per exposed block face
+    Greedy   // Coplanar faces of the same block merged into maximal rectangles
+};
+
+enum class MeshFormat {
+    Vertices, // Four packed vertices per quad, indexed through the shared QuadIndexBuffer
+    Faces     // One packed record per quad, expanded on the GPU by face.vert
+};
+
+// Quads per face direction, in Top, Bottom, Right, Left, Front, Back order. Meshes
+// store each direction's quads contiguously in that order.
+using FaceCounts = std::array<uint32_t, 6>;
 
 class Chunk {
 public:
     static constexpr int WIDTH = 16;
     static constexpr int HEIGHT = 128;
     static constexpr int DEPTH = 16;
+    static constexpr int SECTION_HEIGHT = 16;
+    static constexpr int SECTIONS = HEIGHT / SECTION_HEIGHT;
+    static constexpr int LODS = 4; // Full detail, then meshed from 2x, 4x and 8x coarser blocks
+
+    // A 16x16x16 slice of the chunk, meshed and drawn on its own
+    struct Section {
+        bool dirty = true;
+        bool uploadPending = false;
+        bool interactive = false; // Edited before, so meshed per face to allow patching later edits
+        MeshMode mode = MeshMode::Greedy;
+        MeshFormat format = MeshFormat::Vertices;
+        MeshSpan mesh;            // Packed vertices or face records waiting for upload, released after it
+        FaceCounts faceQuads{};   // Of the latest mesh, pending or uploaded
+
+        // Interactive sections keep their uploaded per-face mesh on the CPU so edits can
+        // patch it, with the face -> quad slot index and back (see ChunkMesher::patchFace)
+        std::vector<uint32_t> patchMesh;
+        std::vector<uint16_t> faceSlots;
+        std::vector<uint16_t> slotFaces;
+
+        // What the GPU currently holds, which lags behind `mesh` until the upload
+        GeometryAllocation gpuMesh;
+        MeshFormat gpuFormat = MeshFormat::Vertices;
+        size_t gpuQuads = 0;
+        FaceCounts gpuFaceQuads{};
+
+        size_t quadCount() const {
+            size_t total = 0;
+            for (uint32_t quads : faceQuads) total += quads;
+            return total;
+        }
+    };
 
     glm::ivec3 position;
-    std::vector<uint8_t> blocks;
-    
-    unsigned int VAO, VBO, EBO;
-    bool meshDirty = true;
+    std::array<BlockStorage, SECTIONS> blocks; // Per section, indexed by index()
+    std::array<Section, SECTIONS> sections;
+    // One above each column's highest non-air block, 0 for an empty column; kept by setBlock
+    std::array<uint8_t, WIDTH * DEPTH> surface{};
+
+    bool meshDirty = true;  // Any section dirty
+    bool meshing = false;   // A background mesh job for this chunk is in flight
+    uint32_t version = 0;   // Bumped whenever sections are dirtied, to drop stale background meshes
+    uint8_t lod = 0;        // Level of detail the chunk is meshed at, see ChunkSnapshot::downsample
 
     Chunk(glm::ivec3 pos);
 
-    uint8_t getBlock(int x, int y, int z) const;
-    void setBlock(int x, int y, int z, uint8_t block);
+    // Of a block within its section, so y < SECTION_HEIGHT; the order depends on BLOCK_LAYOUT
+    static constexpr int index(int x, int y, int z) { return Layout::index<Layout::SELECTED>(x, y, z); }
+
+    BlockId getBlock(int x, int y, int z) const;
+    // Pass remesh = false when the caller patches the affected meshes itself
+    void setBlock(int x, int y, int z, BlockId block, bool remesh = true);
+    // Id every block of the section holds, or -1 when they differ
+    int uniformBlock(int section) const { return blocks[section].uniform() ? blocks[section].get(0) : -1; }
+    int surfaceHeight(int x, int z) const { return surface[x + z * WIDTH]; }
+    // The WIDTH blocks of row y, z as render ids
+    void copyRow(int y, int z, uint8_t* out) const;
+
+    void markDirty();
+    void markSectionDirty(int section);
+    // Switches the level of detail, remeshing the chunk when it changes
+    void setLod(int lod);
 
-    void buildMesh(const World& world);
-    void render();
+    // Returns the dirty sections as a bitmask and clears their flags
+    uint8_t takeDirtySections();
+    uint8_t interactiveSections() const;
+    void applySectionMesh(int section, MeshMode mode, MeshFormat format, MeshSpan mesh, const FaceCounts& faceQuads);
 
-private:
-    std::vector<float> vertices;
-    std::vector<unsigned int> indices;
+    // Remeshes dirty sections on the calling thread; uploadSection then sends them to the GPU.
+    // Coarser levels of detail are always meshed greedily.
+    void buildMesh(const World& world, MeshMode mode = MeshMode::Greedy, MeshFormat format = MeshFormat::Vertices);
+    // Returns the number of bytes uploaded
+    size_t uploadSection(int section, GeometryPool& geometry, StreamBuffer& stream);
+
+    // True when the section's per-face mesh is on the GPU with nothing newer pending
+    bool canPatch(int section, MeshFormat format) const;
+    // Uploads the quad slots a patch rewrote, or the whole section when it outgrew its range;
+    // returns the number of bytes uploaded
+    size_t uploadPatch(int section, std::vector<uint32_t>& changedSlots, GeometryPool& geometry, StreamBuffer& stream);
+
+    size_t quadCount() const;
+    // Mesh data still held on the CPU: pending uploads and patchable sections
+    size_t meshBytes() const;
+    size_t blockBytes() const;
 };
+
+static_assert(BlockStorage::SIZE == Chunk::WIDTH * Chunk::SECTION_HEIGHT * Chunk::DEPTH, "one storage per section");
+static_assert(Chunk::WIDTH == 16 && Chunk::SECTION_HEIGHT == 16 && Chunk::DEPTH == 16, "layouts index 16^3 sections");
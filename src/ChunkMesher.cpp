@@ -0,0 +1,242 @@
+#include "ChunkMesher.h"
+#include "ChunkSnapshot.h"
+#include "FaceMasks.h"
+#include "PackedVertex.h"
+#include <algorithm>
+
+namespace {
+    // Face order shared with FaceMasks and the shaders: Top, Bottom, Right, Left, Front, Back
+    struct FaceDesc {
+        int axis;   // Axis the face normal points along
+        int sign;   // Direction of the normal along that axis
+        int uAxis;  // Axis the quad width runs along
+        int vAxis;  // Axis the quad height runs along
+    };
+
+    constexpr FaceDesc FACES[6] = {
+        {1, +1, 0, 2}, // Top
+        {1, -1, 0, 2}, // Bottom
+        {0, +1, 1, 2}, // Right
+        {0, -1, 1, 2}, // Left
+        {2, +1, 0, 1}, // Front
+        {2, -1, 0, 1}, // Back
+    };
+
+    constexpr int STRIDE[3] = {1, Chunk::WIDTH * Chunk::DEPTH, Chunk::WIDTH}; // maskIndex step along x, y, z
+
+    constexpr int maskIndex(int x, int y, int z) { return x * STRIDE[0] + y * STRIDE[1] + z * STRIDE[2]; }
+
+    constexpr uint16_t NO_SLOT = 0xFFFF;
+    constexpr int FACE_KEYS = Chunk::WIDTH * Chunk::SECTION_HEIGHT * Chunk::DEPTH * 6;
+
+    // Section-local block position and face direction packed into one index
+    constexpr int faceKey(int x, int y, int z, int face) {
+        return ((y * Chunk::DEPTH + z) * Chunk::WIDTH + x) * 6 + face;
+    }
+
+    static_assert(FACE_KEYS <= NO_SLOT, "face keys and quad slots must fit 16 bits");
+    static_assert(Chunk::WIDTH < 32 && Chunk::HEIGHT < 256 && Chunk::DEPTH < 32, "corners must fit the PackedVertex fields");
+    static_assert(Chunk::WIDTH <= 16 && Chunk::HEIGHT <= 128 && Chunk::DEPTH <= 16, "blocks must fit the PackedFace fields");
+}
+
+void ChunkMesher::buildSection(const ChunkSnapshot& snapshot, const FaceMasks& masks, int section,
+                               MeshMode mode, MeshFormat format, std::vector<uint32_t>& out, FaceCounts& faceQuads) {
+    out.clear();
+    // Air and buried sections, which uniform storage makes common
+    if (masks.count(section * Chunk::SECTION_HEIGHT, (section + 1) * Chunk::SECTION_HEIGHT) == 0) {
+        faceQuads.fill(0);
+        return;
+    }
+    if (mode == MeshMode::Greedy)
+        buildGreedy(snapshot, masks, section * Chunk::SECTION_HEIGHT, format, out, faceQuads);
+    else
+        buildFaces(snapshot, masks, section * Chunk::SECTION_HEIGHT, format, out, faceQuads);
+}
+
+void ChunkMesher::buildFaces(const ChunkSnapshot& snapshot, const FaceMasks& masks, int yBegin, MeshFormat format, std::vector<uint32_t>& out, FaceCounts& faceQuads) {
+    const int yEnd = yBegin + Chunk::SECTION_HEIGHT;
+    size_t faceCount = masks.count(yBegin, yEnd);
+    const size_t wordsPerQuad = format == MeshFormat::Faces ? 1 : 4;
+    out.reserve(faceCount * wordsPerQuad);
+
+    for (int face = 0; face < 6; ++face) {
+        size_t start = out.size();
+        masks.forEach(face, yBegin, yEnd, [&](int x, int y, int z) {
+            addQuad(format, out, face, x, y, z, 1, 1, snapshot.get(x, y, z));
+        });
+        faceQuads[face] = static_cast<uint32_t>((out.size() - start) / wordsPerQuad);
+    }
+}
+
+void ChunkMesher::buildGreedy(const ChunkSnapshot& snapshot, const FaceMasks& masks, int yBegin, MeshFormat format, std::vector<uint32_t>& out, FaceCounts& faceQuads) {
+    const int yEnd = yBegin + Chunk::SECTION_HEIGHT;
+    const int lo[3] = {0, yBegin, 0};
+    const int hi[3] = {Chunk::WIDTH, yEnd, Chunk::DEPTH};
+    const int maxExtent = format == MeshFormat::Faces ? PackedFace::MAX_EXTENT : std::max(Chunk::WIDTH, Chunk::SECTION_HEIGHT);
+    const size_t wordsPerQuad = format == MeshFormat::Faces ? 1 : 4;
+
+    exposed.resize(Chunk::WIDTH * Chunk::HEIGHT * Chunk::DEPTH);
+
+    for (int face = 0; face < 6; ++face) {
+        const FaceDesc& f = FACES[face];
+        const int strideU = STRIDE[f.uAxis];
+        const int strideV = STRIDE[f.vAxis];
+        size_t start = out.size();
+
+        // Block type of every exposed face in this direction, 0 elsewhere
+        std::fill(exposed.begin() + maskIndex(0, yBegin, 0), exposed.begin() + maskIndex(0, yEnd, 0), 0);
+        masks.forEach(face, yBegin, yEnd, [&](int x, int y, int z) {
+            exposed[maskIndex(x, y, z)] = snapshot.get(x, y, z);
+        });
+
+        for (int slice = lo[f.axis]; slice < hi[f.axis]; ++slice) {
+            uint8_t* mask = &exposed[slice * STRIDE[f.axis]];
+
+            // Grow each unvisited face along u, then along v while whole rows match
+            for (int v = lo[f.vAxis]; v < hi[f.vAxis]; ++v) {
+                for (int u = lo[f.uAxis]; u < hi[f.uAxis];) {
+                    uint8_t block = mask[u * strideU + v * strideV];
+                    if (block == 0) {
+                        ++u;
+                        continue;
+                    }
+
+                    int w = 1;
+                    while (u + w < hi[f.uAxis] && w < maxExtent && mask[(u + w) * strideU + v * strideV] == block) ++w;
+
+                    int h = 1;
+                    for (; v + h < hi[f.vAxis] && h < maxExtent; ++h) {
+                        bool rowMatches = true;
+                        for (int k = 0; k < w && rowMatches; ++k) {
+                            rowMatches = mask[(u + k) * strideU + (v + h) * strideV] == block;
+                        }
+                        if (!rowMatches) break;
+                    }
+
+                    for (int dv = 0; dv < h; ++dv) {
+                        for (int k = 0; k < w; ++k) {
+                            mask[(u + k) * strideU + (v + dv) * strideV] = 0;
+                        }
+                    }
+
+                    glm::ivec3 p(0);
+                    p[f.axis] = slice;
+                    p[f.uAxis] = u;
+                    p[f.vAxis] = v;
+                    addQuad(format, out, face, p.x, p.y, p.z, w, h, block);
+                    u += w;
+                }
+            }
+        }
+        faceQuads[face] = static_cast<uint32_t>((out.size() - start) / wordsPerQuad);
+    }
+}
+
+void ChunkMesher::patchFace(Chunk::Section& section, int x, int y, int z, int face, uint8_t block,
+                            std::vector<uint32_t>& changedSlots) {
+    const int yBegin = y - y % Chunk::SECTION_HEIGHT;
+    if (section.faceSlots.empty()) indexFaces(section, yBegin);
+
+    const size_t wordsPerQuad = section.format == MeshFormat::Faces ? 1 : 4;
+    const int key = faceKey(x, y - yBegin, z, face);
+    uint32_t slot = section.faceSlots[key];
+    if (block == 0 && slot == NO_SLOT) return;
+
+    std::vector<uint32_t> quad;
+    if (block != 0) addQuad(section.format, quad, face, x, y, z, 1, 1, block);
+    if (block != 0 && slot != NO_SLOT) {
+        std::copy(quad.begin(), quad.end(), section.patchMesh.begin() + slot * wordsPerQuad);
+        changedSlots.push_back(slot);
+        return;
+    }
+
+    uint32_t groupStart[6];
+    for (int g = 0, start = 0; g < 6; start += section.faceQuads[g++]) groupStart[g] = start;
+    FaceCounts& counts = section.faceQuads;
+
+    if (block == 0) {
+        uint32_t hole = slot;
+        for (int g = face; g < 6; ++g) {
+            if (counts[g] == 0) continue;
+            uint32_t last = groupStart[g] + counts[g] - 1;
+            moveQuad(section, last, hole, changedSlots);
+            hole = last;
+        }
+        counts[face]--;
+        section.faceSlots[key] = NO_SLOT;
+        section.patchMesh.resize(section.patchMesh.size() - wordsPerQuad);
+        section.slotFaces.pop_back();
+    } else {
+        uint32_t hole = static_cast<uint32_t>(section.slotFaces.size());
+        section.patchMesh.resize(section.patchMesh.size() + wordsPerQuad);
+        section.slotFaces.push_back(0);
+        for (int g = 5; g > face; --g) {
+            if (counts[g] == 0) continue;
+            moveQuad(section, groupStart[g], hole, changedSlots);
+            hole = groupStart[g];
+        }
+        counts[face]++;
+        std::copy(quad.begin(), quad.end(), section.patchMesh.begin() + hole * wordsPerQuad);
+        section.faceSlots[key] = static_cast<uint16_t>(hole);
+        section.slotFaces[hole] = static_cast<uint16_t>(key);
+        changedSlots.push_back(hole);
+    }
+}
+
+void ChunkMesher::indexFaces(Chunk::Section& section, int yBegin) {
+    const bool records = section.format == MeshFormat::Faces;
+    const size_t quads = section.quadCount();
+    section.faceSlots.assign(FACE_KEYS, NO_SLOT);
+    section.slotFaces.resize(quads);
+
+    for (size_t slot = 0; slot < quads; ++slot) {
+        int p[3], face;
+        if (records) {
+            uint32_t record = section.patchMesh[slot];
+            p[0] = record & 15;
+            p[1] = (record >> 4) & 127;
+            p[2] = (record >> 11) & 15;
+            face = (record >> 15) & 7;
+        } else {
+            // The first corner is the block's minimum corner, pushed out along positive normals
+            uint32_t vertex = section.patchMesh[slot * 4];
+            p[0] = vertex & 31;
+            p[1] = (vertex >> 5) & 255;
+            p[2] = (vertex >> 13) & 31;
+            face = (vertex >> 18) & 7;
+            if (FACES[face].sign > 0) p[FACES[face].axis] -= 1;
+        }
+        int key = faceKey(p[0], p[1] - yBegin, p[2], face);
+        section.faceSlots[key] = static_cast<uint16_t>(slot);
+        section.slotFaces[slot] = static_cast<uint16_t>(key);
+    }
+}
+
+void ChunkMesher::moveQuad(Chunk::Section& section, uint32_t from, uint32_t to, std::vector<uint32_t>& changedSlots) {
+    if (from == to) return;
+    const size_t wordsPerQuad = section.format == MeshFormat::Faces ? 1 : 4;
+    std::copy_n(section.patchMesh.begin() + from * wordsPerQuad, wordsPerQuad, section.patchMesh.begin() + to * wordsPerQuad);
+    uint16_t key = section.slotFaces[from];
+    section.slotFaces[to] = key;
+    section.faceSlots[key] = static_cast<uint16_t>(to);
+    changedSlots.push_back(to);
+}
+
+// Appends a quad covering w x h block faces starting at block (x, y, z)
+void ChunkMesher::addQuad(MeshFormat format, std::vector<uint32_t>& out, int face, int x, int y, int z, int w, int h, uint8_t block) {
+    static constexpr int corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    const FaceDesc& f = FACES[face];
+
+    if (format == MeshFormat::Faces) {
+        out.push_back(PackedFace::pack(x, y, z, face, block, w, h));
+        return;
+    }
+
+    for (const auto& [cu, cv] : corners) {
+        int p[3] = {x, y, z};
+        if (f.sign > 0) p[f.axis] += 1;
+        p[f.uAxis] += cu * w;
+        p[f.vAxis] += cv * h;
+        out.push_back(PackedVertex::pack(p[0], p[1], p[2], face, block));
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Chunk.h"
+
+struct ChunkSnapshot;
+struct FaceMasks;
+
+// Turns a chunk snapshot into section meshes. Holds only scratch memory, so one
+// mesher per thread can run without locking.
+class ChunkMesher {
+public:
+    // Meshes the rows of one section into `out` as packed vertices or face records,
+    // grouped by face direction with the size of each group in `faceQuads`
+    void buildSection(const ChunkSnapshot& snapshot, const FaceMasks& masks, int section,
+                      MeshMode mode, MeshFormat format, std::vector<uint32_t>& out, FaceCounts& faceQuads);
+
+    // Adds, rewrites or, for block 0, removes the face of block (x, y, z) pointing along
+    // `face` in the patch mesh of a PerFace section, appending the rewritten quad slots to `changedSlots`.
+    // Quads stay grouped by direction: a hole is filled by the last quad of its group and
+    // every later group moves its last quad to its front, or the reverse when adding.
+    static void patchFace(Chunk::Section& section, int x, int y, int z, int face, uint8_t block,
+                          std::vector<uint32_t>& changedSlots);
+
+private:
+    std::vector<uint8_t> exposed; // Greedy merge mask for the whole chunk, x fastest, then z, then y
+
+    void buildFaces(const ChunkSnapshot& snapshot, const FaceMasks& masks, int yBegin, MeshFormat format, std::vector<uint32_t>& out, FaceCounts& faceQuads);
+    void buildGreedy(const ChunkSnapshot& snapshot, const FaceMasks& masks, int yBegin, MeshFormat format, std::vector<uint32_t>& out, FaceCounts& faceQuads);
+    static void addQuad(MeshFormat format, std::vector<uint32_t>& out, int face, int x, int y, int z, int w, int h, uint8_t block);
+    static void indexFaces(Chunk::Section& section, int yBegin);
+    static void moveQuad(Chunk::Section& section, uint32_t from, uint32_t to, std::vector<uint32_t>& changedSlots);
+};
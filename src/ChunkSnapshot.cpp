@@ -0,0 +1,129 @@
+#include "ChunkSnapshot.h"
+#include "World.h"
+#include <cstring>
+#include <vector>
+
+static_assert(ChunkSnapshot::SECTION_BYTES % sizeof(uint64_t) == 0, "sectionHash reads whole words");
+
+namespace {
+    // A cell of `cell` blocks per side is solid when at least half of it is, taking its topmost solid block
+    template <typename Get>
+    uint8_t coarseBlock(int cx, int cy, int cz, int cell, Get get) {
+        int solid = 0;
+        uint8_t top = 0;
+        for (int y = cy; y < cy + cell; ++y) {
+            for (int z = cz; z < cz + cell; ++z) {
+                for (int x = cx; x < cx + cell; ++x) {
+                    uint8_t block = get(x, y, z);
+                    if (block == 0) continue;
+                    solid++;
+                    top = block;
+                }
+            }
+        }
+        return solid * 2 >= cell * cell * cell ? top : 0;
+    }
+}
+
+void ChunkSnapshot::capture(const World& world, const Chunk& chunk) {
+    blocks.fill(0);
+
+    for (int y = 0; y < Chunk::HEIGHT; ++y) {
+        for (int z = 0; z < Chunk::DEPTH; ++z) {
+            chunk.copyRow(y, z, &blocks[index(0, y, z)]);
+        }
+    }
+
+    // Border slices from the four horizontal neighbors
+    const Chunk* left = world.getChunk(chunk.position.x - 1, chunk.position.z);
+    const Chunk* right = world.getChunk(chunk.position.x + 1, chunk.position.z);
+    const Chunk* back = world.getChunk(chunk.position.x, chunk.position.z - 1);
+    const Chunk* front = world.getChunk(chunk.position.x, chunk.position.z + 1);
+    lod = chunk.lod;
+    auto seam = [&](const Chunk* neighbor) { return neighbor && neighbor->lod != lod; };
+    if (seam(left)) left = nullptr;
+    if (seam(right)) right = nullptr;
+    if (seam(back)) back = nullptr;
+    if (seam(front)) front = nullptr;
+
+    airSections = 0;
+    for (int section = 0; section < Chunk::SECTIONS; ++section) {
+        bool air = chunk.uniformBlock(section) == 0;
+        for (const Chunk* neighbor : {left, right, back, front}) air &= !neighbor || neighbor->uniformBlock(section) == 0;
+        if (air) airSections |= 1u << section;
+    }
+
+    if (lod != 0) {
+        if (left) captureCoarseBorder(*left, -1, 0);
+        if (right) captureCoarseBorder(*right, 1, 0);
+        if (back) captureCoarseBorder(*back, 0, -1);
+        if (front) captureCoarseBorder(*front, 0, 1);
+        return;
+    }
+    for (int y = 0; y < Chunk::HEIGHT; ++y) {
+        for (int z = 0; z < Chunk::DEPTH; ++z) {
+            if (left) blocks[index(-1, y, z)] = Blocks::renderId(left->getBlock(Chunk::WIDTH - 1, y, z));
+            if (right) blocks[index(Chunk::WIDTH, y, z)] = Blocks::renderId(right->getBlock(0, y, z));
+        }
+        if (back) back->copyRow(y, Chunk::DEPTH - 1, &blocks[index(0, y, -1)]);
+        if (front) front->copyRow(y, 0, &blocks[index(0, y, Chunk::DEPTH)]);
+    }
+}
+
+// The border facing a neighbor at the same coarse level, made of the neighbor's
+// cells along the shared side as downsample will see them
+void ChunkSnapshot::captureCoarseBorder(const Chunk& neighbor, int dx, int dz) {
+    constexpr int W = Chunk::WIDTH, D = Chunk::DEPTH;
+    thread_local std::vector<uint8_t> rows(size_t(W) * Chunk::HEIGHT * D);
+    for (int y = 0; y < Chunk::HEIGHT; ++y) {
+        for (int z = 0; z < D; ++z) neighbor.copyRow(y, z, &rows[z * W + y * W * D]);
+    }
+    auto get = [&](int x, int y, int z) { return rows[x + z * W + y * W * D]; };
+
+    const int cell = 1 << lod;
+    const int length = dx != 0 ? D : W;
+    for (int cy = 0; cy < Chunk::HEIGHT; cy += cell) {
+        for (int c = 0; c < length; c += cell) {
+            // Cell origin inside the neighbor, and where its row lands in this border
+            int cx = dx != 0 ? (dx > 0 ? 0 : W - cell) : c;
+            int cz = dz != 0 ? (dz > 0 ? 0 : D - cell) : c;
+            uint8_t block = coarseBlock(cx, cy, cz, cell, get);
+            for (int y = cy; y < cy + cell; ++y) {
+                for (int i = c; i < c + cell; ++i) {
+                    if (dx != 0) blocks[index(dx > 0 ? W : -1, y, i)] = block;
+                    else blocks[index(i, y, dz > 0 ? D : -1)] = block;
+                }
+            }
+        }
+    }
+}
+
+void ChunkSnapshot::downsample() {
+    if (lod == 0) return;
+    const int cell = 1 << lod;
+
+    for (int cy = 0; cy < Chunk::HEIGHT; cy += cell) {
+        for (int cz = 0; cz < Chunk::DEPTH; cz += cell) {
+            for (int cx = 0; cx < Chunk::WIDTH; cx += cell) {
+                uint8_t block = coarseBlock(cx, cy, cz, cell, [&](int x, int y, int z) { return get(x, y, z); });
+                for (int y = cy; y < cy + cell; ++y) {
+                    for (int z = cz; z < cz + cell; ++z) {
+                        std::memset(&blocks[index(cx, y, z)], block, cell);
+                    }
+                }
+            }
+        }
+    }
+}
+
+uint64_t ChunkSnapshot::sectionHash(int section, uint64_t seed) const {
+    const uint8_t* data = sectionRows(section);
+    uint64_t hash = seed ^ 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < SECTION_BYTES; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
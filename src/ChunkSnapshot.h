@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "Chunk.h"
+
+class World;
+
+// Copy of a chunk's blocks surrounded by a one-block border taken from its
+// neighbors, so meshing can read any face neighbor without bounds checks or
+// chunk lookups. Blocks outside the world (below 0, above HEIGHT, unloaded
+// neighbors) read as air.
+//
+// Sides facing a neighbor at another level of detail are captured as air, so
+// both chunks draw walls (skirts) down them that cover the seam. Coarse chunks
+// take the border from a neighbor at their own level already downsampled, so
+// the faces between them cull as they do at full detail.
+struct ChunkSnapshot {
+    static constexpr int SIZE_X = Chunk::WIDTH + 2;
+    static constexpr int SIZE_Y = Chunk::HEIGHT + 2;
+    static constexpr int SIZE_Z = Chunk::DEPTH + 2;
+    static constexpr int STRIDE[3] = {1, SIZE_X * SIZE_Z, SIZE_X}; // Index step along x, y, z
+
+    // Render ids: the registry and the packed mesh formats hold 8 bits per block
+    std::array<uint8_t, SIZE_X * SIZE_Y * SIZE_Z> blocks;
+    uint8_t lod = 0; // Chunk::lod at capture
+    uint8_t airSections = 0; // Bit s set when section s and the border beside it hold only air
+
+    // Chunk-local coordinates, each may lie one block outside the chunk
+    static constexpr int index(int x, int y, int z) {
+        return (x + 1) + (z + 1) * SIZE_X + (y + 1) * SIZE_X * SIZE_Z;
+    }
+
+    uint8_t get(int x, int y, int z) const { return blocks[index(x, y, z)]; }
+
+    void capture(const World& world, const Chunk& chunk);
+    // Replaces every cell of 2^lod blocks per side with one block, so the regular
+    // meshers produce the coarse mesh. A cell is solid when at least half of it
+    // is, taking its topmost solid block. Call once, after capture.
+    void downsample();
+    // Everything a section's mesh depends on besides the settings: its blocks and the
+    // one-block border around them, SECTION_BYTES contiguous bytes
+    static constexpr size_t SECTION_BYTES = (Chunk::SECTION_HEIGHT + 2) * SIZE_X * SIZE_Z;
+    const uint8_t* sectionRows(int section) const { return &blocks[index(-1, section * Chunk::SECTION_HEIGHT - 1, -1)]; }
+    // Hash of sectionRows. `seed` distinguishes mesh settings and must include the
+    // section, since meshes hold chunk-local heights.
+    uint64_t sectionHash(int section, uint64_t seed) const;
+
+private:
+    void captureCoarseBorder(const Chunk& neighbor, int dx, int dz);
+};
@@ -0,0 +1,75 @@
+#include "FaceMasks.h"
+#include "ChunkSnapshot.h"
+#include "Blocks.h"
+
+void FaceMasks::build(const ChunkSnapshot& snapshot) {
+    constexpr int SX = ChunkSnapshot::SIZE_X;
+    constexpr int SZ = ChunkSnapshot::SIZE_Z;
+    constexpr int LAYER = SX * SZ;
+
+    // Per padded column: blocks drawn at all, blocks hiding their neighbors, and blocks
+    // hiding neighbors of their own type. The snapshot's y padding is air so it is left out.
+    std::array<Column, LAYER> drawn{}, opaque{}, selfCulling{};
+    for (int y = 0; y < Chunk::HEIGHT; ++y) {
+        if (snapshot.airSections & (1u << (y / Chunk::SECTION_HEIGHT))) continue;
+        const uint8_t* layer = &snapshot.blocks[ChunkSnapshot::index(-1, y, -1)];
+        const int word = y >> 6, bit = y & 63;
+        for (int i = 0; i < LAYER; ++i) {
+            drawn[i][word] |= uint64_t(Blocks::DRAWN[layer[i]]) << bit;
+            opaque[i][word] |= uint64_t(Blocks::OPAQUE[layer[i]]) << bit;
+            selfCulling[i][word] |= uint64_t(Blocks::SELF_CULLING[layer[i]]) << bit;
+        }
+    }
+
+    // Of the self-culling `candidates` in word w of the column at `base`, those whose
+    // neighbor `step` entries away holds the same block. Rare, so tested block by block.
+    auto sameType = [&](uint64_t candidates, int w, int base, int step) {
+        uint64_t same = 0;
+        for (; candidates; candidates &= candidates - 1) {
+            int bit = std::countr_zero(candidates);
+            int i = base + (w * 64 + bit) * LAYER;
+            same |= uint64_t(snapshot.blocks[i] == snapshot.blocks[i + step]) << bit;
+        }
+        return same;
+    };
+
+    for (int z = 0; z < Chunk::DEPTH; ++z) {
+        for (int x = 0; x < Chunk::WIDTH; ++x) {
+            const int padded = (x + 1) + (z + 1) * SX;
+            const int base = ChunkSnapshot::index(x, 0, z);
+            const int column = x + z * Chunk::WIDTH;
+            const int sides[4] = {1, -1, SX, -SX}; // Right, Left, Front, Back
+
+            for (int w = 0; w < WORDS; ++w) {
+                const uint64_t d = drawn[padded][w];
+                const uint64_t self = selfCulling[padded][w];
+                const Column& o = opaque[padded];
+                const Column& s = selfCulling[padded];
+                const uint64_t opaqueAbove = (o[w] >> 1) | (w + 1 < WORDS ? o[w + 1] << 63 : 0);
+                const uint64_t opaqueBelow = (o[w] << 1) | (w > 0 ? o[w - 1] >> 63 : 0);
+                const uint64_t selfAbove = (s[w] >> 1) | (w + 1 < WORDS ? s[w + 1] << 63 : 0);
+                const uint64_t selfBelow = (s[w] << 1) | (w > 0 ? s[w - 1] >> 63 : 0);
+
+                faces[0][column][w] = d & ~opaqueAbove & ~sameType(self & selfAbove, w, base, LAYER);
+                faces[1][column][w] = d & ~opaqueBelow & ~sameType(self & selfBelow, w, base, -LAYER);
+                for (int side = 0; side < 4; ++side) {
+                    const int neighbor = padded + sides[side];
+                    faces[2 + side][column][w] = d & ~opaque[neighbor][w] &
+                                                 ~sameType(self & selfCulling[neighbor][w], w, base, sides[side]);
+                }
+            }
+        }
+    }
+}
+
+size_t FaceMasks::count(int yBegin, int yEnd) const {
+    size_t total = 0;
+    for (int word = 0; word < WORDS; ++word) {
+        const uint64_t range = rangeMask(word, yBegin, yEnd);
+        if (range == 0) continue;
+        for (const auto& direction : faces) {
+            for (const Column& column : direction) total += std::popcount(column[word] & range);
+        }
+    }
+    return total;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include "Chunk.h"
+
+struct ChunkSnapshot;
+
+// Exposed faces of a chunk for all six directions, stored per column as
+// Chunk::HEIGHT-bit masks (bit y set when the face of block y is visible).
+// Masks are derived from per-column bits looked up in the block registry
+// (drawn, opaque, self-culling) with whole-column shifts and ANDs instead of
+// testing blocks one at a time.
+struct FaceMasks {
+    static_assert(Chunk::HEIGHT % 64 == 0, "columns must fill whole 64-bit words");
+    static constexpr int WORDS = Chunk::HEIGHT / 64;
+    static constexpr int COLUMNS = Chunk::WIDTH * Chunk::DEPTH;
+
+    using Column = std::array<uint64_t, WORDS>;
+
+    // Indexed [face][x + z * WIDTH], faces in Top, Bottom, Right, Left, Front, Back order
+    std::array<std::array<Column, COLUMNS>, 6> faces;
+
+    void build(const ChunkSnapshot& snapshot);
+
+    // Bits of `word` covering rows yBegin..yEnd-1
+    static constexpr uint64_t rangeMask(int word, int yBegin, int yEnd) {
+        int lo = std::clamp(yBegin - word * 64, 0, 64);
+        int hi = std::clamp(yEnd - word * 64, 0, 64);
+        uint64_t below = hi == 64 ? ~uint64_t(0) : (uint64_t(1) << hi) - 1;
+        return lo == 64 ? 0 : below & ~((uint64_t(1) << lo) - 1);
+    }
+
+    // Calls emit(x, y, z) for every exposed face in the given direction with yBegin <= y < yEnd
+    template <typename F>
+    void forEach(int face, int yBegin, int yEnd, F&& emit) const {
+        for (int word = yBegin / 64; word < WORDS && word * 64 < yEnd; ++word) {
+            const uint64_t range = rangeMask(word, yBegin, yEnd);
+            for (int column = 0; column < COLUMNS; ++column) {
+                uint64_t bits = faces[face][column][word] & range;
+                while (bits) {
+                    emit(column % Chunk::WIDTH, word * 64 + std::countr_zero(bits), column / Chunk::WIDTH);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+
+    size_t count(int yBegin = 0, int yEnd = Chunk::HEIGHT) const;
+};
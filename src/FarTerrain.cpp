@@ -0,0 +1,213 @@
+#include "FarTerrain.h"
+#include "Chunk.h"
+#include "Noise.h"
+#include "Shader.h"
+#include "World.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace {
+    // Height samples per axis averaged into each vertex, so coarse levels don't alias
+    constexpr int SAMPLES = 4;
+    constexpr int TILE_VERTICES = FarTerrain::TILE_CELLS + 1;
+
+    int floorDiv(int value, int divisor) {
+        return value >= 0 ? value / divisor : (value - (divisor - 1)) / divisor;
+    }
+
+    // Rectangles as min x, min z, max x, max z
+    bool contains(const glm::vec4& outer, const glm::vec4& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y && inner.z <= outer.z && inner.w <= outer.w;
+    }
+}
+
+void FarTerrain::render(Shader& shader, const World& world, const glm::vec3& cameraPos, const glm::vec4& voxelHole) {
+    init();
+    frame++;
+    stats.tilesDrawn = 0;
+    stats.tilesPending = 0;
+    int builds = 0;
+
+    shader.setInt("heights", 3);
+    shader.setVec4("voxelHole", voxelHole);
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heightTexture);
+    glBindVertexArray(vao);
+
+    // Each level leaves out the area of the finer ones, once they are completely built
+    glm::vec4 finerHole(0.0f);
+    for (int level = 0; level < LEVELS; ++level) {
+        int size = tileBlocks(level);
+        glm::ivec2 first(static_cast<int>(std::floor(cameraPos.x / size)) - RING_TILES / 2,
+                         static_cast<int>(std::floor(cameraPos.z / size)) - RING_TILES / 2);
+        shader.setVec4("finerHole", finerHole);
+        shader.setFloat("cellSize", float(BASE_CELL << level));
+
+        bool complete = true;
+        for (int z = 0; z < RING_TILES; ++z) {
+            for (int x = 0; x < RING_TILES; ++x) {
+                glm::ivec2 index = first + glm::ivec2(x, z);
+                glm::vec4 bounds(index.x * size, index.y * size, (index.x + 1) * size, (index.y + 1) * size);
+                if (contains(voxelHole, bounds) || contains(finerHole, bounds)) continue;
+
+                int slot = acquireSlot(level, index);
+                Tile& tile = tiles[slot];
+                if (!tile.built || tile.dirty) {
+                    if (builds < BUILDS_PER_FRAME) {
+                        buildTile(world, slot);
+                        builds++;
+                    } else {
+                        stats.tilesPending++;
+                    }
+                }
+                if (!tile.built) {
+                    complete = false;
+                    continue;
+                }
+
+                shader.setInt("slot", slot);
+                shader.setVec2("origin", bounds.x, bounds.y);
+                glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, nullptr);
+                stats.tilesDrawn++;
+            }
+        }
+        if (complete) {
+            finerHole = glm::vec4(first.x * size, first.y * size, (first.x + RING_TILES) * size, (first.y + RING_TILES) * size);
+        }
+    }
+
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    stats.tilesResident = slots.size();
+}
+
+void FarTerrain::invalidate(const glm::ivec3& chunk) {
+    glm::ivec2 min(chunk.x * Chunk::WIDTH, chunk.z * Chunk::DEPTH);
+    glm::ivec2 max = min + glm::ivec2(Chunk::WIDTH, Chunk::DEPTH);
+    for (Tile& tile : tiles) {
+        if (tile.level < 0) continue;
+        // Vertices on the tile edge average half a cell beyond it
+        int size = tileBlocks(tile.level), cell = BASE_CELL << tile.level;
+        glm::ivec2 tileMin = tile.index * size - cell, tileMax = (tile.index + 1) * size + cell;
+        if (min.x < tileMax.x && max.x > tileMin.x && min.y < tileMax.y && max.y > tileMin.y) tile.dirty = true;
+    }
+}
+
+void FarTerrain::init() {
+    if (vao != 0) return;
+    tiles.resize(MAX_TILES);
+    heights.resize(TILE_VERTICES * TILE_VERTICES);
+
+    // One ring of vertices outside the grid becomes the skirt in terrain.vert
+    std::vector<int16_t> grid;
+    for (int z = -1; z <= TILE_CELLS + 1; ++z) {
+        for (int x = -1; x <= TILE_CELLS + 1; ++x) grid.insert(grid.end(), {int16_t(x), int16_t(z)});
+    }
+    const int row = TILE_CELLS + 3;
+    std::vector<uint16_t> indices;
+    for (int z = 0; z < row - 1; ++z) {
+        for (int x = 0; x < row - 1; ++x) {
+            uint16_t corner = static_cast<uint16_t>(z * row + x);
+            indices.insert(indices.end(), {corner, uint16_t(corner + row), uint16_t(corner + row + 1),
+                                           uint16_t(corner + row + 1), uint16_t(corner + 1), corner});
+        }
+    }
+    indexCount = static_cast<int>(indices.size());
+
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &gridBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, gridBuffer);
+    glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(int16_t), grid.data(), GL_STATIC_DRAW);
+    glVertexAttribIPointer(0, 2, GL_SHORT, 2 * sizeof(int16_t), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenTextures(1, &heightTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heightTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, TILE_VERTICES * LAYER_TILES, TILE_VERTICES * LAYER_TILES, LAYERS, 0,
+                 GL_RED, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// Finds the tile's slot, or takes over the one least recently needed
+int FarTerrain::acquireSlot(int level, glm::ivec2 index) {
+    uint64_t key = tileKey(level, index);
+    auto known = slots.find(key);
+    if (known != slots.end()) {
+        tiles[known->second].lastUsed = frame;
+        return known->second;
+    }
+
+    int slot = -1;
+    for (int i = 0; i < MAX_TILES; ++i) {
+        if (tiles[i].level < 0) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 || tiles[i].lastUsed < tiles[slot].lastUsed) slot = i;
+    }
+    Tile& tile = tiles[slot];
+    if (tile.level >= 0) slots.erase(tileKey(tile.level, tile.index));
+    tile = Tile{level, index, false, false, frame};
+    slots.emplace(key, slot);
+    return slot;
+}
+
+void FarTerrain::buildTile(const World& world, int slot) {
+    Tile& tile = tiles[slot];
+    int size = tileBlocks(tile.level), cell = BASE_CELL << tile.level;
+    int step = std::max(1, cell / SAMPLES), samples = cell / step;
+    glm::ivec2 origin = tile.index * size - cell / 2 + step / 2;
+
+    // Samples of a cell mostly share a chunk, so it is only looked up again when they leave it
+    glm::ivec2 chunkPos(INT_MAX);
+    const Chunk* chunk = nullptr;
+    for (int z = 0; z < TILE_VERTICES; ++z) {
+        for (int x = 0; x < TILE_VERTICES; ++x) {
+            float sum = 0.0f;
+            for (int sz = 0; sz < samples; ++sz) {
+                for (int sx = 0; sx < samples; ++sx) {
+                    int blockX = origin.x + x * cell + sx * step, blockZ = origin.y + z * cell + sz * step;
+                    glm::ivec2 pos(floorDiv(blockX, Chunk::WIDTH), floorDiv(blockZ, Chunk::DEPTH));
+                    if (pos != chunkPos) {
+                        chunkPos = pos;
+                        chunk = world.getChunk(pos.x, pos.y);
+                    }
+                    sum += sampleHeight(chunk, blockX, blockZ);
+                }
+            }
+            heights[z * TILE_VERTICES + x] = sum / float(samples * samples);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, heightTexture);
+    const int perLayer = LAYER_TILES * LAYER_TILES;
+    const int column = slot % LAYER_TILES, row = slot / LAYER_TILES % LAYER_TILES;
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, column * TILE_VERTICES, row * TILE_VERTICES, slot / perLayer,
+                    TILE_VERTICES, TILE_VERTICES, 1, GL_RED, GL_FLOAT, heights.data());
+    tile.built = true;
+    tile.dirty = false;
+    stats.tilesBuilt++;
+}
+
+// Height of the column's top surface, in blocks; `chunk` is the one holding the column, if loaded
+float FarTerrain::sampleHeight(const Chunk* chunk, int x, int z) {
+    if (chunk) {
+        return float(chunk->surfaceHeight(x - chunk->position.x * Chunk::WIDTH, z - chunk->position.z * Chunk::DEPTH));
+    }
+    // Same columns the chunk constructor would generate
+    return std::ceil(Noise::generate(float(x), float(z)) * Chunk::HEIGHT);
+}
+
+uint64_t FarTerrain::tileKey(int level, glm::ivec2 index) {
+    return uint64_t(level) << 56 | uint64_t(uint32_t(index.x) & 0xFFFFFFF) << 28 | (uint32_t(index.y) & 0xFFFFFFF);
+}
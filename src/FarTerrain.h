@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+class Chunk;
+class Shader;
+class World;
+
+struct FarTerrainStats {
+    size_t tilesDrawn = 0;    // Last frame
+    size_t tilesResident = 0;
+    size_t tilesBuilt = 0;    // Total, including rebuilds after chunk changes
+    size_t tilesPending = 0;  // Needed but not built or out of date, waiting for the per-frame budget
+};
+
+// Terrain beyond the voxel render distance, drawn as a geometry clipmap: LEVELS
+// nested squares of RING_TILES x RING_TILES tiles around the camera, each level
+// with cells twice the size of the one inside it. A tile is a TILE_CELLS grid
+// whose heights, averaged over each cell, live in one slot of a texture array
+// that terrain.vert samples. Heights come from loaded chunks where there are any
+// and from the terrain generator elsewhere. Tiles are only built when they come
+// into range or the chunks under them change, a few per frame.
+class FarTerrain {
+public:
+    static constexpr int LEVELS = 9;
+    static constexpr int TILE_CELLS = 16;  // Keep in sync with terrain.vert
+    static constexpr int BASE_CELL = 4;    // Blocks per cell at level 0
+    static constexpr int RING_TILES = 6;   // Per side, which keeps every level inside the next
+    static constexpr int MAX_TILES = LEVELS * RING_TILES * RING_TILES;
+    // Tiles side by side in each layer of the height array, so it stays within the
+    // 256 layers GL 3.3 guarantees. Keep in sync with terrain.vert
+    static constexpr int LAYER_TILES = 2;
+    static constexpr int LAYERS = (MAX_TILES + LAYER_TILES * LAYER_TILES - 1) / (LAYER_TILES * LAYER_TILES);
+    static_assert(LAYERS <= 256, "GL_MAX_ARRAY_TEXTURE_LAYERS may be as low as 256");
+    static constexpr int BUILDS_PER_FRAME = 4;
+    // Blocks from the camera to the nearest outer edge of the coarsest level
+    static constexpr float VIEW_DISTANCE = float((RING_TILES / 2 - 1) * TILE_CELLS * (BASE_CELL << (LEVELS - 1)));
+
+    // Draws everything outside `voxelHole`, the xz block range drawn as chunks, given as
+    // min x, min z, max x, max z. The shader needs view and projection set.
+    void render(Shader& shader, const World& world, const glm::vec3& cameraPos, const glm::vec4& voxelHole);
+    // Marks the tiles over the chunk for rebuilding
+    void invalidate(const glm::ivec3& chunk);
+
+    const FarTerrainStats& getStats() const { return stats; }
+
+private:
+    struct Tile {
+        int level = -1; // -1 while the slot is unused
+        glm::ivec2 index{0};
+        bool built = false;
+        bool dirty = false;
+        uint32_t lastUsed = 0;
+    };
+
+    unsigned int vao = 0;
+    unsigned int gridBuffer = 0;
+    unsigned int indexBuffer = 0;
+    unsigned int heightTexture = 0; // R32F array, LAYER_TILES x LAYER_TILES tile slots per layer
+    int indexCount = 0;
+    std::vector<Tile> tiles;
+    std::unordered_map<uint64_t, int> slots; // Tile key -> slot, which picks the place in the texture array
+    std::vector<float> heights;              // Scratch for one tile
+    uint32_t frame = 0;
+    FarTerrainStats stats;
+
+    void init();
+    int acquireSlot(int level, glm::ivec2 index);
+    void buildTile(const World& world, int slot);
+    static float sampleHeight(const Chunk* chunk, int x, int z);
+    static uint64_t tileKey(int level, glm::ivec2 index);
+    static int tileBlocks(int level) { return TILE_CELLS * (BASE_CELL << level); }
+};
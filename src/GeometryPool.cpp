@@ -0,0 +1,247 @@
+#include "GeometryPool.h"
+#include "StreamBuffer.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+GeometryAllocation::~GeometryAllocation() {
+    reset();
+}
+
+GeometryAllocation::GeometryAllocation(GeometryAllocation&& other) noexcept
+    : pool(std::exchange(other.pool, nullptr)), id(std::exchange(other.id, 0)) {}
+
+GeometryAllocation& GeometryAllocation::operator=(GeometryAllocation&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool = std::exchange(other.pool, nullptr);
+        id = std::exchange(other.id, 0);
+    }
+    return *this;
+}
+
+void GeometryAllocation::reset() {
+    if (pool) pool->release(id);
+    pool = nullptr;
+    id = 0;
+}
+
+void GeometryPool::upload(GeometryAllocation& allocation, glm::ivec3 chunk, const void* data, size_t bytes, StreamBuffer& stream) {
+    uint32_t pages = static_cast<uint32_t>((bytes + PAGE_BYTES - 1) / PAGE_BYTES);
+    if (pages == 0 || (allocation.valid() && ranges[allocation.id].pages < pages)) allocation.reset();
+    if (pages == 0) return;
+    init();
+
+    if (!allocation.valid()) {
+        uint32_t id;
+        if (!unusedIds.empty()) {
+            id = unusedIds.back();
+            unusedIds.pop_back();
+        } else {
+            id = static_cast<uint32_t>(ranges.size());
+            ranges.emplace_back();
+        }
+        if (!allocate(ranges[id], pages)) {
+            compact(size_t(usedPages + pages) * PAGE_BYTES);
+            allocate(ranges[id], pages);
+        }
+        ranges[id].chunk = chunk;
+        assignPages(ranges[id]);
+        allocation.pool = this;
+        allocation.id = id;
+    }
+
+    // Give back the tail of ranges that shrank a lot, keeping some room to grow in place
+    Range& range = ranges[allocation.id];
+    if (range.pages > pages * 2) {
+        freePages(range.page + pages, range.pages - pages);
+        range.pages = pages;
+    }
+    if (range.chunk != chunk) {
+        range.chunk = chunk;
+        assignPages(range);
+    }
+
+    size_t offset = size_t(range.page) * PAGE_BYTES;
+    if (stream.available() && bytes <= stream.capacity()) {
+        size_t source = stream.write(data, bytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, stream.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source, offset, bytes);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+size_t GeometryPool::wordOffset(const GeometryAllocation& allocation) const {
+    return size_t(ranges[allocation.id].page) * (PAGE_BYTES / sizeof(uint32_t));
+}
+
+size_t GeometryPool::capacityWords(const GeometryAllocation& allocation) const {
+    return size_t(ranges[allocation.id].pages) * (PAGE_BYTES / sizeof(uint32_t));
+}
+
+void GeometryPool::update(const GeometryAllocation& allocation, size_t firstWord, const uint32_t* data, size_t words) {
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, (wordOffset(allocation) + firstWord) * sizeof(uint32_t), words * sizeof(uint32_t), data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryPool::flush() {
+    if (dirtyBegin >= dirtyEnd) return;
+    glBindBuffer(GL_TEXTURE_BUFFER, pageBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, size_t(dirtyBegin) * 2 * sizeof(int32_t),
+                    size_t(dirtyEnd - dirtyBegin) * 2 * sizeof(int32_t), &pageTable[size_t(dirtyBegin) * 2]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    dirtyBegin = UINT32_MAX;
+    dirtyEnd = 0;
+}
+
+void GeometryPool::compact(size_t minBytes) {
+    init();
+    uint32_t newPageCount = pageCount;
+    uint32_t needed = static_cast<uint32_t>((minBytes + PAGE_BYTES - 1) / PAGE_BYTES);
+    if (needed > pageCount) {
+        newPageCount = std::max(needed, pageCount * 2);
+        counters.growths++;
+    }
+
+    unsigned int oldBuffer = buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, size_t(newPageCount) * PAGE_BYTES, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, oldBuffer);
+
+    // Keep the current order so chunks uploaded together stay together
+    std::vector<Range*> live;
+    for (Range& range : ranges) {
+        if (range.pages > 0) live.push_back(&range);
+    }
+    std::sort(live.begin(), live.end(), [](const Range* a, const Range* b) { return a->page < b->page; });
+
+    uint32_t next = 0;
+    for (Range* range : live) {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            size_t(range->page) * PAGE_BYTES, size_t(next) * PAGE_BYTES, size_t(range->pages) * PAGE_BYTES);
+        range->page = next;
+        next += range->pages;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &oldBuffer);
+
+    pageCount = newPageCount;
+    freeList.clear();
+    if (next < pageCount) freeList.emplace(next, pageCount - next);
+
+    pageTable.assign(size_t(pageCount) * 2, 0);
+    for (Range* range : live) assignPages(*range);
+    glBindBuffer(GL_TEXTURE_BUFFER, pageBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, pageTable.size() * sizeof(int32_t), pageTable.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    dirtyBegin = UINT32_MAX;
+    dirtyEnd = 0;
+
+    attachBuffer();
+    counters.compactions++;
+}
+
+const GeometryPoolStats& GeometryPool::stats() {
+    counters.allocations = ranges.size() - unusedIds.size();
+    counters.usedBytes = size_t(usedPages) * PAGE_BYTES;
+    counters.capacityBytes = size_t(pageCount) * PAGE_BYTES;
+    counters.freeRanges = freeList.size();
+    counters.largestFreeBytes = 0;
+    for (const auto& free : freeList) {
+        counters.largestFreeBytes = std::max(counters.largestFreeBytes, size_t(free.second) * PAGE_BYTES);
+    }
+    return counters;
+}
+
+void GeometryPool::init() {
+    if (vao != 0) return;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &buffer);
+    glGenBuffers(1, &pageBuffer);
+    glGenTextures(1, &texture);
+    glGenTextures(1, &pageTexture);
+
+    pageCount = static_cast<uint32_t>(INITIAL_BYTES / PAGE_BYTES);
+    freeList.emplace(0, pageCount);
+    pageTable.assign(size_t(pageCount) * 2, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, INITIAL_BYTES, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, pageBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, pageTable.size() * sizeof(int32_t), pageTable.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    attachBuffer();
+}
+
+bool GeometryPool::allocate(Range& range, uint32_t pages) {
+    for (auto it = freeList.begin(); it != freeList.end(); ++it) {
+        if (it->second < pages) continue;
+        range.page = it->first;
+        range.pages = pages;
+        uint32_t rest = it->second - pages;
+        freeList.erase(it);
+        if (rest > 0) freeList.emplace(range.page + pages, rest);
+        usedPages += pages;
+        return true;
+    }
+    return false;
+}
+
+void GeometryPool::release(uint32_t id) {
+    Range& range = ranges[id];
+    freePages(range.page, range.pages);
+    range.pages = 0;
+    unusedIds.push_back(id);
+}
+
+void GeometryPool::freePages(uint32_t page, uint32_t pages) {
+    usedPages -= pages;
+    auto next = freeList.lower_bound(page);
+    if (next != freeList.end() && next->first == page + pages) {
+        pages += next->second;
+        next = freeList.erase(next);
+    }
+    if (next != freeList.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == page) {
+            prev->second += pages;
+            return;
+        }
+    }
+    freeList.emplace_hint(next, page, pages);
+}
+
+void GeometryPool::assignPages(const Range& range) {
+    for (uint32_t page = range.page; page < range.page + range.pages; ++page) {
+        pageTable[size_t(page) * 2] = range.chunk.x;
+        pageTable[size_t(page) * 2 + 1] = range.chunk.z;
+    }
+    dirtyBegin = std::min(dirtyBegin, range.page);
+    dirtyEnd = std::max(dirtyEnd, range.page + range.pages);
+}
+
+void GeometryPool::attachBuffer() {
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, pageTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32I, pageBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
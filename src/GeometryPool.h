@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <glm/vec3.hpp>
+
+class GeometryPool;
+class StreamBuffer;
+
+struct GeometryPoolStats {
+    size_t allocations = 0;
+    size_t usedBytes = 0;     // Rounded up to whole pages
+    size_t capacityBytes = 0;
+    size_t freeRanges = 0;
+    size_t largestFreeBytes = 0;
+    size_t compactions = 0;
+    size_t growths = 0;
+
+    // Share of free memory that is not in the largest free range
+    float fragmentation() const {
+        size_t freeBytes = capacityBytes - usedBytes;
+        return freeBytes == 0 ? 0.0f : 1.0f - float(largestFreeBytes) / float(freeBytes);
+    }
+};
+
+// Owning handle to a range of a GeometryPool; the range is freed on destruction.
+// Freeing only updates bookkeeping, so handles can be destroyed at any time.
+class GeometryAllocation {
+public:
+    GeometryAllocation() = default;
+    ~GeometryAllocation();
+    GeometryAllocation(GeometryAllocation&& other) noexcept;
+    GeometryAllocation& operator=(GeometryAllocation&& other) noexcept;
+    GeometryAllocation(const GeometryAllocation&) = delete;
+    GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+
+    bool valid() const { return pool != nullptr; }
+    void reset();
+
+private:
+    friend class GeometryPool;
+    GeometryPool* pool = nullptr;
+    uint32_t id = 0;
+};
+
+// All chunk geometry lives in one buffer, carved into fixed-size pages by a
+// first-fit free list. A page table buffer texture maps every page to the
+// chunk that owns it, so the shaders find the chunk origin from gl_VertexID
+// and the whole world draws under one VAO with a single multi-draw call.
+// When no free range fits, the live ranges are compacted into a new buffer,
+// which also grows it when needed. Must only be used on the GL thread.
+class GeometryPool {
+public:
+    static constexpr size_t PAGE_BYTES = 1024; // Keep in sync with PAGE_WORDS in the chunk shaders
+    static constexpr size_t INITIAL_BYTES = 32 * 1024 * 1024;
+
+    unsigned int vao = 0;
+    unsigned int buffer = 0;
+    unsigned int texture = 0;     // R32UI view of the buffer for MeshFormat::Faces
+    unsigned int pageTexture = 0; // RG32I chunk x, z per page
+
+    // Writes `bytes` for the chunk at `chunk`, reusing the allocation's range when it fits
+    void upload(GeometryAllocation& allocation, glm::ivec3 chunk, const void* data, size_t bytes, StreamBuffer& stream);
+    // Offset of the allocation in 32-bit words, which is both its base vertex and its first face record
+    size_t wordOffset(const GeometryAllocation& allocation) const;
+    size_t capacityWords(const GeometryAllocation& allocation) const;
+    // Overwrites part of an allocation in place with glBufferSubData, for small patches
+    void update(const GeometryAllocation& allocation, size_t firstWord, const uint32_t* data, size_t words);
+
+    // Uploads page table changes; call once before drawing
+    void flush();
+    // Moves all live ranges to the front of a new buffer of at least `minBytes`
+    void compact(size_t minBytes = 0);
+
+    const GeometryPoolStats& stats();
+
+private:
+    friend class GeometryAllocation;
+
+    struct Range {
+        uint32_t page = 0;
+        uint32_t pages = 0; // 0 when the slot is unused
+        glm::ivec3 chunk{0};
+    };
+
+    unsigned int pageBuffer = 0;
+    std::vector<Range> ranges;
+    std::vector<uint32_t> unusedIds;
+    std::map<uint32_t, uint32_t> freeList; // First page -> page count, coalesced
+    std::vector<int32_t> pageTable;        // Two ints per page
+    uint32_t pageCount = 0;
+    uint32_t usedPages = 0;
+    uint32_t dirtyBegin = UINT32_MAX, dirtyEnd = 0;
+    GeometryPoolStats counters;
+
+    void init();
+    bool allocate(Range& range, uint32_t pages);
+    void release(uint32_t id);
+    void freePages(uint32_t page, uint32_t pages);
+    void assignPages(const Range& range);
+    void attachBuffer();
+};
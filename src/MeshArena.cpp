@@ -0,0 +1,46 @@
+#include "MeshArena.h"
+#include <algorithm>
+
+MeshArena::MeshArena() : freeList(std::make_shared<FreeList>()) {}
+
+MeshSpan MeshArena::store(const uint32_t* data, size_t words) {
+    MeshSpan span;
+    if (words == 0) return span;
+    if (!block || used + words > block->size()) nextBlock(words);
+
+    std::copy_n(data, words, block->data() + used);
+    span.words = std::shared_ptr<const uint32_t>(block, block->data() + used);
+    span.count = words;
+    used += words;
+    return span;
+}
+
+void MeshArena::nextBlock(size_t minWords) {
+    std::unique_ptr<Block> fresh;
+    {
+        std::lock_guard<std::mutex> lock(freeList->mutex);
+        auto fits = std::find_if(freeList->blocks.begin(), freeList->blocks.end(),
+                                 [&](const std::unique_ptr<Block>& b) { return b->size() >= minWords; });
+        if (fits != freeList->blocks.end()) {
+            fresh = std::move(*fits);
+            freeList->blocks.erase(fits);
+        }
+    }
+    if (!fresh) {
+        fresh = std::make_unique<Block>(std::max(BLOCK_WORDS, minWords));
+        reserved += fresh->size() * sizeof(uint32_t);
+    }
+
+    // The free list outlives the arena for as long as spans from it exist
+    std::shared_ptr<FreeList> list = freeList;
+    block = std::shared_ptr<Block>(fresh.release(), [list](Block* released) {
+        std::lock_guard<std::mutex> lock(list->mutex);
+        if (list->blocks.size() < MAX_FREE_BLOCKS) {
+            list->blocks.emplace_back(released);
+        } else {
+            reserved -= released->size() * sizeof(uint32_t);
+            delete released;
+        }
+    });
+    used = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A finished mesh stored in a MeshArena. Holding the span keeps its block alive;
+// the block is recycled once every span in it is gone.
+class MeshSpan {
+public:
+    const uint32_t* data() const { return words.get(); }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    friend class MeshArena;
+    std::shared_ptr<const uint32_t> words;
+    size_t count = 0;
+};
+
+// Bump allocator for meshes between meshing and upload, owned by one thread.
+// Memory comes in blocks that return to the arena's free list when their last
+// span is released, so steady-state meshing does not touch the heap and nothing
+// stays resident once meshes are on the GPU. Spans may be released on any thread.
+class MeshArena {
+public:
+    static constexpr size_t BLOCK_WORDS = 256 * 1024; // 1 MB
+    static constexpr size_t MAX_FREE_BLOCKS = 4;      // Beyond this, released blocks are freed
+
+    MeshArena();
+
+    MeshSpan store(const uint32_t* data, size_t words);
+    MeshSpan store(const std::vector<uint32_t>& words) { return store(words.data(), words.size()); }
+
+    // Memory held by all arenas, in use or free
+    static size_t reservedBytes() { return reserved; }
+
+private:
+    using Block = std::vector<uint32_t>;
+
+    struct FreeList {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Block>> blocks;
+
+        ~FreeList() {
+            for (const auto& block : blocks) reserved -= block->size() * sizeof(uint32_t);
+        }
+    };
+
+    static inline std::atomic<size_t> reserved{0};
+
+    std::shared_ptr<FreeList> freeList;
+    std::shared_ptr<Block> block;
+    size_t used = 0;
+
+    void nextBlock(size_t minWords);
+};
@@ -0,0 +1,49 @@
+#include "MeshCache.h"
+#include "ChunkSnapshot.h"
+#include <cstring>
+
+std::shared_ptr<const MeshCache::Entry> MeshCache::find(uint64_t key, uint64_t settings, const uint8_t* rows) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = slots.find(key);
+    if (it == slots.end()) {
+        counters.misses++;
+        return nullptr;
+    }
+    const Entry& entry = *it->second.entry;
+    if (entry.settings != settings || std::memcmp(entry.rows.data(), rows, entry.rows.size()) != 0) {
+        counters.collisions++;
+        counters.misses++;
+        return nullptr;
+    }
+    counters.hits++;
+    recent.splice(recent.begin(), recent, it->second.recent);
+    return it->second.entry;
+}
+
+void MeshCache::insert(uint64_t key, uint64_t settings, const uint8_t* rows, const std::vector<uint32_t>& mesh, const FaceCounts& faceQuads) {
+    auto entry = std::make_shared<const Entry>(
+        Entry{mesh, faceQuads, settings, std::vector<uint8_t>(rows, rows + ChunkSnapshot::SECTION_BYTES)});
+    size_t bytes = entryBytes(*entry);
+    if (bytes > MAX_BYTES) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // Another worker may have meshed the same content meanwhile
+    if (slots.count(key)) return;
+
+    while (counters.bytes + bytes > MAX_BYTES && !recent.empty()) {
+        auto oldest = slots.find(recent.back());
+        counters.bytes -= entryBytes(*oldest->second.entry);
+        slots.erase(oldest);
+        recent.pop_back();
+    }
+    recent.push_front(key);
+    slots.emplace(key, Slot{std::move(entry), recent.begin()});
+    counters.bytes += bytes;
+}
+
+MeshCacheStats MeshCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    MeshCacheStats copy = counters;
+    copy.entries = slots.size();
+    return copy;
+}
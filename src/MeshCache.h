@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Chunk.h"
+
+struct MeshCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t collisions = 0; // Key matched but the blocks or settings did not, counted as misses
+
+    float hitRate() const { return hits + misses == 0 ? 0.0f : float(hits) / float(hits + misses); }
+};
+
+// Section meshes keyed by a hash of the blocks they were built from (see
+// ChunkSnapshot::sectionHash) and the mesh settings, so repeated terrain and
+// uniform regions skip meshing. Entries keep the blocks and settings too, so a
+// hash collision is a miss rather than the wrong mesh. The least recently used
+// entries are evicted past MAX_BYTES. Safe to use from several threads.
+class MeshCache {
+public:
+    static constexpr size_t MAX_BYTES = 32 * 1024 * 1024;
+
+    struct Entry {
+        std::vector<uint32_t> mesh;
+        FaceCounts faceQuads;
+        uint64_t settings;
+        std::vector<uint8_t> rows; // ChunkSnapshot::sectionRows
+    };
+
+    // Returns nullptr on a miss
+    std::shared_ptr<const Entry> find(uint64_t key, uint64_t settings, const uint8_t* rows);
+    void insert(uint64_t key, uint64_t settings, const uint8_t* rows, const std::vector<uint32_t>& mesh, const FaceCounts& faceQuads);
+    MeshCacheStats stats() const;
+
+private:
+    struct Slot {
+        std::shared_ptr<const Entry> entry;
+        std::list<uint64_t>::iterator recent;
+    };
+
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, Slot> slots;
+    std::list<uint64_t> recent; // Most recently used first
+    MeshCacheStats counters;
+
+    static size_t entryBytes(const Entry& entry) {
+        return sizeof(Entry) + entry.mesh.size() * sizeof(uint32_t) + entry.rows.size();
+    }
+};
@@ -0,0 +1,89 @@
+#include "MeshWorkers.h"
+#include "ChunkMesher.h"
+#include "FaceMasks.h"
+#include <chrono>
+
+MeshWorkers::MeshWorkers(unsigned int threadCount) {
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&MeshWorkers::run, this);
+    }
+}
+
+MeshWorkers::~MeshWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void MeshWorkers::submit(MeshJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        inFlight++;
+    }
+    wake.notify_one();
+}
+
+void MeshWorkers::collect(std::vector<MeshResult>& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (MeshResult& result : results) out.push_back(std::move(result));
+    inFlight -= results.size();
+    results.clear();
+}
+
+size_t MeshWorkers::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return inFlight;
+}
+
+void MeshWorkers::run() {
+    ChunkMesher mesher;
+    MeshArena arena;
+    std::vector<uint32_t> scratch;
+    auto masks = std::make_unique<FaceMasks>();
+
+    while (true) {
+        MeshJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        job.snapshot->downsample();
+        MeshResult result{job.chunk, job.version, job.sections, {}, job.format, {}, {}, 0.0};
+        bool masksBuilt = false;
+        for (int i = 0; i < Chunk::SECTIONS; ++i) {
+            if (!(job.sections & (1u << i))) continue;
+
+            MeshMode mode = job.perFace & (1u << i) ? MeshMode::PerFace : job.mode;
+            result.modes[i] = mode;
+            // Meshes hold chunk-local heights, so equal blocks in another section need their own mesh
+            uint64_t settings = uint64_t(i) << 16 | uint64_t(mode) << 8 | uint64_t(job.format);
+            uint64_t key = job.snapshot->sectionHash(i, settings);
+            const uint8_t* rows = job.snapshot->sectionRows(i);
+            if (auto cached = cache.find(key, settings, rows)) {
+                result.meshes[i] = arena.store(cached->mesh);
+                result.faceQuads[i] = cached->faceQuads;
+                continue;
+            }
+            if (!masksBuilt) {
+                masks->build(*job.snapshot);
+                masksBuilt = true;
+            }
+            mesher.buildSection(*job.snapshot, *masks, i, mode, job.format, scratch, result.faceQuads[i]);
+            cache.insert(key, settings, rows, scratch, result.faceQuads[i]);
+            result.meshes[i] = arena.store(scratch);
+        }
+        result.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(std::move(result));
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Chunk.h"
+#include "ChunkSnapshot.h"
+#include "MeshCache.h"
+
+struct MeshJob {
+    glm::ivec3 chunk;
+    uint32_t version;  // Chunk::version when the snapshot was taken
+    uint8_t sections;  // Bit i set for every section to mesh
+    uint8_t perFace;   // Sections meshed MeshMode::PerFace regardless of mode, so edits can patch them
+    MeshMode mode;
+    MeshFormat format;
+    std::unique_ptr<ChunkSnapshot> snapshot;
+};
+
+struct MeshResult {
+    glm::ivec3 chunk;
+    uint32_t version;
+    uint8_t sections;
+    std::array<MeshMode, Chunk::SECTIONS> modes;
+    MeshFormat format;
+    std::array<MeshSpan, Chunk::SECTIONS> meshes; // In the worker's arena
+    std::array<FaceCounts, Chunk::SECTIONS> faceQuads;
+    double buildMs;
+};
+
+// Pool of threads turning chunk snapshots into CPU-side meshes. Jobs carry
+// their own copy of the blocks, so workers never touch the World; results are
+// collected and uploaded by the render thread. Each worker meshes into its own
+// scratch vector and keeps finished meshes in its own MeshArena until upload.
+class MeshWorkers {
+public:
+    explicit MeshWorkers(unsigned int threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1);
+    ~MeshWorkers();
+
+    void submit(MeshJob job);
+    // Moves every finished result into `out` without waiting
+    void collect(std::vector<MeshResult>& out);
+    size_t pending() const;
+    MeshCacheStats cacheStats() const { return cache.stats(); }
+
+private:
+    std::vector<std::thread> threads;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<MeshJob> jobs;
+    std::vector<MeshResult> results;
+    size_t inFlight = 0;
+    bool stopping = false;
+    MeshCache cache;
+
+    void run();
+};
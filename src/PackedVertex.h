@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// Chunk mesh vertex packed into a single 32-bit integer, unpacked in vert.glsl:
+//   bits  0-4   x corner, 0..16
+//   bits  5-12  y corner, 0..128
+//   bits 13-17  z corner, 0..16
+//   bits 18-20  face direction (Top, Bottom, Right, Left, Front, Back)
+//   bits 21-28  block type
+// Corners are block-grid coordinates, so texture coordinates are derived in the
+// shader from the position on the face plane and repeat across greedy quads.
+namespace PackedVertex {
+    constexpr uint32_t pack(int x, int y, int z, int face, uint8_t block) {
+        return static_cast<uint32_t>(x)
+             | static_cast<uint32_t>(y) << 5
+             | static_cast<uint32_t>(z) << 13
+             | static_cast<uint32_t>(face) << 18
+             | static_cast<uint32_t>(block) << 21;
+    }
+}
+
+// One visible quad packed into 32 bits for the vertex-pulling path. face.vert
+// reads the record from a buffer texture and expands it into a quad from
+// gl_VertexID:
+//   bits  0-3   x block, 0..15
+//   bits  4-10  y block, 0..127
+//   bits 11-14  z block, 0..15
+//   bits 15-17  face direction (Top, Bottom, Right, Left, Front, Back)
+//   bits 18-25  block type
+//   bits 26-28  quad width - 1
+//   bits 29-31  quad height - 1
+namespace PackedFace {
+    constexpr int MAX_EXTENT = 8; // Greedy quads are split to fit the 3-bit extents
+
+    constexpr uint32_t pack(int x, int y, int z, int face, uint8_t block, int w, int h) {
+        return static_cast<uint32_t>(x)
+             | static_cast<uint32_t>(y) << 4
+             | static_cast<uint32_t>(z) << 11
+             | static_cast<uint32_t>(face) << 15
+             | static_cast<uint32_t>(block) << 18
+             | static_cast<uint32_t>(w - 1) << 26
+             | static_cast<uint32_t>(h - 1) << 29;
+    }
+}
@@ -0,0 +1,21 @@
+#include "QuadIndexBuffer.h"
+#include <GL/glew.h>
+#include <vector>
+
+void QuadIndexBuffer::bind(size_t quads) {
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+
+    if (quads <= quadCapacity) return;
+
+    size_t capacity = quadCapacity > 0 ? quadCapacity : INITIAL_QUADS;
+    while (capacity < quads) capacity *= 2;
+
+    std::vector<unsigned int> indices;
+    indices.reserve(capacity * 6);
+    for (unsigned int offset = 0; offset < capacity * 4; offset += 4) {
+        indices.insert(indices.end(), {offset, offset + 1, offset + 2, offset + 2, offset + 3, offset});
+    }
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    quadCapacity = capacity;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+// Element buffer holding the {0, 1, 2, 2, 3, 0} pattern offset by 4 per quad,
+// shared by every chunk VAO. Growing re-specifies the same buffer name, so
+// VAOs that already reference it stay valid.
+class QuadIndexBuffer {
+public:
+    static constexpr size_t INITIAL_QUADS = 16384;
+
+    // Binds the buffer to the current VAO, growing it to cover at least `quads` quads
+    void bind(size_t quads);
+
+    size_t capacity() const { return quadCapacity; }
+    size_t bytes() const { return quadCapacity * 6 * sizeof(unsigned int); }
+
+private:
+    unsigned int buffer = 0;
+    size_t quadCapacity = 0;
+};
@@ -0,0 +1,68 @@
+#include "StreamBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+bool StreamBuffer::init(size_t bufferSize) {
+    if (initialized) return available();
+    initialized = true;
+
+    if (!GLEW_ARB_buffer_storage && !GLEW_VERSION_4_4) {
+        std::cout << "ARB_buffer_storage not supported, uploading meshes with glBufferSubData" << std::endl;
+        return false;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glBufferStorage(GL_COPY_READ_BUFFER, bufferSize, nullptr, flags);
+    mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, bufferSize, flags));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (!mapped) {
+        std::cout << "Failed to map stream buffer, uploading meshes with glBufferSubData" << std::endl;
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+        return false;
+    }
+    size = bufferSize;
+    return true;
+}
+
+size_t StreamBuffer::write(const void* data, size_t bytes) {
+    size_t offset = (head + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (offset + bytes > size) {
+        // Wrap around; fence the tail end first so it is protected like any other range
+        head = std::min(offset, size);
+        fence();
+        offset = 0;
+        unfencedBegin = 0;
+    }
+
+    waitUntilFree(offset, offset + bytes);
+    std::memcpy(mapped + offset, data, bytes);
+    head = offset + bytes;
+    return offset;
+}
+
+void StreamBuffer::fence() {
+    if (head == unfencedBegin) return;
+    regions.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), unfencedBegin, head});
+    unfencedBegin = head;
+}
+
+void StreamBuffer::waitUntilFree(size_t begin, size_t end) {
+    auto overlaps = [&](const Region& region) { return region.begin < end && begin < region.end; };
+
+    // Regions are in submission order, so retire from the front until none overlap
+    while (std::any_of(regions.begin(), regions.end(), overlaps)) {
+        Region& oldest = regions.front();
+        GLenum status = glClientWaitSync(oldest.sync, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            waits++;
+            glClientWaitSync(oldest.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        glDeleteSync(oldest.sync);
+        regions.pop_front();
+    }
+}
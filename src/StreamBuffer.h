@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <GL/glew.h>
+
+// Persistently mapped upload ring (ARB_buffer_storage). Mesh data is written
+// straight into GPU-visible memory and copied to its final buffer with
+// glCopyBufferSubData, so uploads skip the driver-side copy of glBufferSubData.
+// Fences mark the ranges the GPU may still be copying from; writes wait on
+// them before reusing that memory. Must only be used on the GL thread.
+class StreamBuffer {
+public:
+    static constexpr size_t DEFAULT_SIZE = 16 * 1024 * 1024;
+    static constexpr size_t ALIGNMENT = 64;
+
+    unsigned int buffer = 0;
+    size_t waits = 0; // Writes that had to block on the GPU
+
+    // Creates the ring on first call; returns false when buffer storage is unsupported
+    bool init(size_t size = DEFAULT_SIZE);
+    bool available() const { return mapped != nullptr; }
+    size_t capacity() const { return size; }
+
+    // Copies `bytes` into the ring and returns their offset; bytes must not exceed capacity()
+    size_t write(const void* data, size_t bytes);
+    // Fences everything written since the last call; call after issuing the copies that read it
+    void fence();
+
+private:
+    struct Region {
+        GLsync sync;
+        size_t begin, end;
+    };
+
+    bool initialized = false;
+    uint8_t* mapped = nullptr;
+    size_t size = 0;
+    size_t head = 0;         // Next free byte
+    size_t unfencedBegin = 0;
+    std::deque<Region> regions;
+
+    void waitUntilFree(size_t begin, size_t end);
+};
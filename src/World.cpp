@@ -1,7 +1,22 @@
 #include "World.h"
+#include "ChunkMesher.h"
+#include "Blocks.h"
 #include <iostream>
 #include <glm/gtc/matrix_transform.hpp>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    // Horizontal neighbor offsets, in chunks or blocks
+    const glm::ivec3 SIDES[4] = {{1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
+
+    // Distance in chunks at which each coarser level of detail starts. Doubling it per
+    // level keeps the triangles per level about the same however far the view reaches.
+    const float LOD_DISTANCES[Chunk::LODS - 1] = {8.0f, 16.0f, 32.0f};
+    // Chunks only switch once this far past a boundary, so they don't flip back and forth on it
+    const float LOD_HYSTERESIS = 1.0f;
+}
 
 World::World() {
     // For now, let's just load a single chunk at the origin
@@ -10,32 +25,287 @@ World::World() {
 
 void World::loadChunk(int x, int z) {
     glm::ivec3 pos(x, 0, z);
-    if (chunks.find(pos) == chunks.end()) {
-        chunks.emplace(pos, Chunk(pos));
+    if (chunks.try_emplace(pos, pos).second) {
         std::cout << "Loading chunk at: " << x << ", " << z << std::endl;
+        farTerrain.invalidate(pos);
+    }
+}
+
+bool World::neighborsLoaded(const glm::ivec3& pos) const {
+    for (const glm::ivec3& side : SIDES) {
+        if (chunks.find(pos + side) == chunks.end()) return false;
     }
+    return true;
 }
 
-void World::update(const glm::vec3& cameraPos, int distance) {
-    // Simple chunk loading logic
+void World::update(const glm::vec3& cameraPos, const glm::vec3& cameraFront, int distance) {
+    this->cameraPos = cameraPos;
+    this->cameraFront = cameraFront;
+
+    // Simple chunk loading logic. Chunks are only meshed once all four neighbors are
+    // loaded, so one extra ring is loaded to mesh everything within the distance.
     int camChunkX = static_cast<int>(cameraPos.x) / Chunk::WIDTH;
     int camChunkZ = static_cast<int>(cameraPos.z) / Chunk::DEPTH;
+    int loadDistance = distance + 1;
+    cameraChunk = glm::ivec3(camChunkX, 0, camChunkZ);
+    renderDistance = distance;
 
-    for (int x = camChunkX - distance; x <= camChunkX + distance; ++x) {
-        for (int z = camChunkZ - distance; z <= camChunkZ + distance; ++z) {
+    for (int x = camChunkX - loadDistance; x <= camChunkX + loadDistance; ++x) {
+        for (int z = camChunkZ - loadDistance; z <= camChunkZ + loadDistance; ++z) {
             loadChunk(x, z);
         }
     }
+    updateLods();
+}
+
+void World::updateLods() {
+    for (auto& pair : chunks) {
+        Chunk& chunk = pair.second;
+        int level = 0;
+        if (lodEnabled) {
+            glm::vec2 offset((pair.first.x + 0.5f) * Chunk::WIDTH - cameraPos.x, (pair.first.z + 0.5f) * Chunk::DEPTH - cameraPos.z);
+            float distance = glm::length(offset) / Chunk::WIDTH;
+            int coarser = 0, finer = 0;
+            for (float boundary : LOD_DISTANCES) {
+                if (distance >= boundary + LOD_HYSTERESIS) coarser++;
+                if (distance >= boundary - LOD_HYSTERESIS) finer++;
+            }
+            level = std::clamp<int>(chunk.lod, coarser, finer);
+        }
+        if (level != chunk.lod) setChunkLod(chunk, level);
+    }
+}
+
+void World::setChunkLod(Chunk& chunk, int lod) {
+    // Skirts go on sides between different levels (see ChunkSnapshot), so neighbors at
+    // the old or the new level gain or lose theirs
+    int previous = chunk.lod;
+    chunk.setLod(lod);
+    for (const glm::ivec3& side : SIDES) {
+        auto neighbor = chunks.find(chunk.position + side);
+        if (neighbor != chunks.end() && (neighbor->second.lod == previous || neighbor->second.lod == lod))
+            neighbor->second.markDirty();
+    }
 }
 
 void World::render(Shader& shader) {
+    applyFinishedMeshes();
+
+    meshStats.chunks = chunks.size();
+    meshStats.quads = 0;
+    meshStats.meshBytes = 0;
+    meshStats.blockBytes = 0;
+    meshStats.uniformSections = 0;
+    meshStats.lodChunks.fill(0);
+
+    meshStats.chunksWaiting = 0;
+    for (auto& pair : chunks) {
+        if (pair.second.meshDirty && !pair.second.meshing) {
+            if (neighborsLoaded(pair.first))
+                scheduleMesh(pair.second);
+            else
+                meshStats.chunksWaiting++;
+        }
+    }
+    uploadMeshes();
+
+    drawFirsts.clear();
+    drawCounts.clear();
+    meshStats.quadsDrawn = 0;
+    size_t maxQuads = 0;
+    auto addDraw = [&](size_t baseWord, size_t firstQuad, size_t quads) {
+        if (quads == 0) return;
+        size_t first = meshFormat == MeshFormat::Faces ? (baseWord + firstQuad) * 6 : baseWord + firstQuad * 4;
+        drawFirsts.push_back(static_cast<int>(first));
+        drawCounts.push_back(static_cast<int>(quads * 6));
+        maxQuads = std::max(maxQuads, quads);
+        meshStats.quadsDrawn += quads;
+    };
+
     for (auto& pair : chunks) {
-        if (pair.second.meshDirty) {
-            pair.second.buildMesh(*this);
+        meshStats.quads += pair.second.quadCount();
+        meshStats.meshBytes += pair.second.meshBytes();
+        meshStats.blockBytes += pair.second.blockBytes();
+        for (int i = 0; i < Chunk::SECTIONS; ++i) meshStats.uniformSections += pair.second.uniformBlock(i) >= 0;
+        meshStats.lodChunks[pair.second.lod]++;
+
+        for (int i = 0; i < Chunk::SECTIONS; ++i) {
+            const Chunk::Section& section = pair.second.sections[i];
+            if (section.gpuQuads == 0 || section.gpuFormat != meshFormat) continue;
+
+            // Draw runs of consecutive facing directions, skipping the rest
+            uint8_t facing = facingDirections(pair.first, i);
+            size_t baseWord = geometry.wordOffset(section.gpuMesh);
+            size_t quad = 0, runStart = 0, runQuads = 0;
+            for (int face = 0; face < 6; ++face) {
+                if (facing & (1u << face)) {
+                    if (runQuads == 0) runStart = quad;
+                    runQuads += section.gpuFaceQuads[face];
+                } else {
+                    addDraw(baseWord, runStart, runQuads);
+                    runQuads = 0;
+                }
+                quad += section.gpuFaceQuads[face];
+            }
+            addDraw(baseWord, runStart, runQuads);
+        }
+    }
+    meshStats.drawRanges = drawCounts.size();
+
+    if (!drawCounts.empty()) {
+        // Chunk origins come from the page table, so there is no per-chunk model matrix
+        geometry.flush();
+        shader.setInt("pages", 2);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_BUFFER, geometry.pageTexture);
+        glBindVertexArray(geometry.vao);
+        if (meshFormat == MeshFormat::Faces) {
+            // No vertex attributes are read; face.vert fetches its record from the buffer texture
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_BUFFER, geometry.texture);
+            glMultiDrawArrays(GL_TRIANGLES, drawFirsts.data(), drawCounts.data(), static_cast<GLsizei>(drawCounts.size()));
+        } else {
+            quadIndices.bind(maxQuads);
+            drawIndices.assign(drawCounts.size(), nullptr);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT, drawIndices.data(),
+                                          static_cast<GLsizei>(drawCounts.size()), drawFirsts.data());
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    meshStats.indexBytes = quadIndices.bytes();
+    meshStats.meshJobsPending = meshWorkers.pending();
+}
+
+void World::renderFarTerrain(Shader& shader) {
+    if (!farTerrainEnabled) return;
+    // Everything within the render distance is meshed as chunks
+    glm::vec4 voxelHole((cameraChunk.x - renderDistance) * Chunk::WIDTH, (cameraChunk.z - renderDistance) * Chunk::DEPTH,
+                        (cameraChunk.x + renderDistance + 1) * Chunk::WIDTH, (cameraChunk.z + renderDistance + 1) * Chunk::DEPTH);
+    farTerrain.render(shader, *this, cameraPos, voxelHole);
+}
+
+void World::scheduleMesh(Chunk& chunk) {
+    MeshJob job;
+    job.chunk = chunk.position;
+    job.version = chunk.version;
+    job.sections = chunk.takeDirtySections();
+    // Coarse chunks are never patched, so they mesh greedily whatever the edit history
+    job.perFace = chunk.lod == 0 ? chunk.interactiveSections() : 0;
+    job.mode = chunk.lod == 0 ? meshMode : MeshMode::Greedy;
+    job.format = meshFormat;
+    job.snapshot = std::make_unique<ChunkSnapshot>();
+    job.snapshot->capture(*this, chunk);
+
+    chunk.meshing = true;
+    meshWorkers.submit(std::move(job));
+}
+
+void World::applyFinishedMeshes() {
+    finishedMeshes.clear();
+    meshWorkers.collect(finishedMeshes);
+
+    for (MeshResult& result : finishedMeshes) {
+        auto it = chunks.find(result.chunk);
+        if (it == chunks.end()) continue;
+
+        Chunk& chunk = it->second;
+        chunk.meshing = false;
+
+        if (result.version != chunk.version) {
+            // Edited while meshing, so the snapshot is stale; mesh again from current blocks
+            for (int i = 0; i < Chunk::SECTIONS; ++i) {
+                if (result.sections & (1u << i)) chunk.markSectionDirty(i);
+            }
+            meshStats.meshesDiscarded++;
+            continue;
         }
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(pair.first.x * Chunk::WIDTH, 0, pair.first.z * Chunk::DEPTH));
-        shader.setMat4("model", model);
-        pair.second.render();
+
+        for (int i = 0; i < Chunk::SECTIONS; ++i) {
+            if (!(result.sections & (1u << i))) continue;
+            if (!chunk.sections[i].uploadPending) uploadQueue.push_back({chunk.position, i, 0.0f});
+            chunk.applySectionMesh(i, result.modes[i], result.format, std::move(result.meshes[i]), result.faceQuads[i]);
+        }
+        meshStats.buildMs += result.buildMs;
+        meshStats.meshesBuilt++;
+    }
+}
+
+void World::uploadMeshes() {
+    meshStats.sectionsUploaded = 0;
+    meshStats.bytesUploaded = 0;
+    meshStats.streaming = streamBuffer.init();
+
+    // Min-heap on priority, so only the sections that fit the budget are ordered
+    for (UploadRequest& request : uploadQueue) request.priority = uploadPriority(request);
+    auto later = [](const UploadRequest& a, const UploadRequest& b) { return a.priority > b.priority; };
+    std::make_heap(uploadQueue.begin(), uploadQueue.end(), later);
+
+    auto start = std::chrono::steady_clock::now();
+    while (!uploadQueue.empty()) {
+        if (meshStats.sectionsUploaded > 0) {
+            float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (meshStats.bytesUploaded >= uploadBudget.bytes || elapsedMs >= uploadBudget.ms) break;
+        }
+
+        std::pop_heap(uploadQueue.begin(), uploadQueue.end(), later);
+        UploadRequest request = uploadQueue.back();
+        uploadQueue.pop_back();
+
+        auto it = chunks.find(request.chunk);
+        if (it == chunks.end()) continue;
+        meshStats.bytesUploaded += it->second.uploadSection(request.section, geometry, streamBuffer);
+        meshStats.sectionsUploaded++;
+    }
+    streamBuffer.fence();
+    meshStats.uploadQueueDepth = uploadQueue.size();
+    meshStats.streamWaits = streamBuffer.waits;
+}
+
+// Distance from the camera to the section center, doubled for sections behind the camera
+float World::uploadPriority(const UploadRequest& request) const {
+    glm::vec3 center((request.chunk.x + 0.5f) * Chunk::WIDTH,
+                     (request.section + 0.5f) * Chunk::SECTION_HEIGHT,
+                     (request.chunk.z + 0.5f) * Chunk::DEPTH);
+    glm::vec3 offset = center - cameraPos;
+    float distance = glm::length(offset);
+    return glm::dot(offset, cameraFront) < 0.0f ? distance * 2.0f : distance;
+}
+
+// Face directions, as bits in face order, that can point at the camera from somewhere in the section
+uint8_t World::facingDirections(const glm::ivec3& chunk, int section) const {
+    // Rendered blocks are centered on integer coordinates
+    glm::vec3 min = glm::vec3(chunk.x * Chunk::WIDTH, section * Chunk::SECTION_HEIGHT, chunk.z * Chunk::DEPTH) - 0.5f;
+    glm::vec3 max = min + glm::vec3(Chunk::WIDTH, Chunk::SECTION_HEIGHT, Chunk::DEPTH);
+
+    uint8_t facing = 0;
+    if (cameraPos.y > min.y) facing |= 1u << 0; // Top
+    if (cameraPos.y < max.y) facing |= 1u << 1; // Bottom
+    if (cameraPos.x > min.x) facing |= 1u << 2; // Right
+    if (cameraPos.x < max.x) facing |= 1u << 3; // Left
+    if (cameraPos.z > min.z) facing |= 1u << 4; // Front
+    if (cameraPos.z < max.z) facing |= 1u << 5; // Back
+    return facing;
+}
+
+void World::setMeshMode(MeshMode mode) {
+    if (mode == meshMode) return;
+    meshMode = mode;
+    remeshAll();
+}
+
+void World::setMeshFormat(MeshFormat format) {
+    if (format == meshFormat) return;
+    meshFormat = format;
+    remeshAll();
+}
+
+void World::remeshAll() {
+    meshStats.meshesBuilt = 0;
+    meshStats.meshesDiscarded = 0;
+    meshStats.buildMs = 0.0;
+    for (auto& pair : chunks) {
+        pair.second.markDirty();
     }
 }
 
@@ -43,12 +313,29 @@ std::optional<RaycastResult> World::raycast(const glm::vec3& start, const glm::v
     glm::ivec3 currentBlock(floor(start.x), floor(start.y), floor(start.z));
     glm::vec3 rayStep = glm::normalize(direction);
 
-    for (float dist = 0; dist < maxDist; dist += 0.05f) {
+    const float step = 0.05f;
+    for (float dist = 0; dist < maxDist; dist += step) {
         glm::vec3 pos = start + rayStep * dist;
         glm::ivec3 blockPos(floor(pos.x), floor(pos.y), floor(pos.z));
 
-        if (getBlock(blockPos) != 0) {
-            glm::vec3 prevPos = start + rayStep * (dist - 0.05f);
+        // Steps through sections of only air at once, landing on the first step past them
+        glm::ivec3 local;
+        const Chunk* chunk = chunkAt(blockPos, local);
+        if (chunk && local.y >= 0 && local.y < Chunk::HEIGHT && chunk->uniformBlock(local.y / Chunk::SECTION_HEIGHT) == 0) {
+            const glm::vec3 size(Chunk::WIDTH, Chunk::SECTION_HEIGHT, Chunk::DEPTH);
+            glm::vec3 cell = glm::floor(pos / size) * size;
+            float exit = maxDist;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (rayStep[axis] == 0.0f) continue;
+                float boundary = cell[axis] + (rayStep[axis] > 0.0f ? size[axis] : 0.0f);
+                exit = std::min(exit, (boundary - pos[axis]) / rayStep[axis]);
+            }
+            dist += std::max(0.0f, std::ceil(exit / step) - 1.0f) * step;
+            continue;
+        }
+
+        if (chunk && chunk->getBlock(local.x, local.y, local.z) != 0) {
+            glm::vec3 prevPos = start + rayStep * (dist - step);
             glm::ivec3 prevBlockPos(floor(prevPos.x), floor(prevPos.y), floor(prevPos.z));
             glm::ivec3 face = blockPos - prevBlockPos;
             return RaycastResult{blockPos, face};
@@ -57,7 +344,12 @@ std::optional<RaycastResult> World::raycast(const glm::vec3& start, const glm::v
     return std::nullopt;
 }
 
-uint8_t World::getBlock(const glm::ivec3& pos) const {
+const Chunk* World::getChunk(int x, int z) const {
+    auto it = chunks.find(glm::ivec3(x, 0, z));
+    return it != chunks.end() ? &it->second : nullptr;
+}
+
+BlockId World::getBlock(const glm::ivec3& pos) const {
     int chunkX = pos.x >= 0 ? pos.x / Chunk::WIDTH : (pos.x - (Chunk::WIDTH - 1)) / Chunk::WIDTH;
     int chunkZ = pos.z >= 0 ? pos.z / Chunk::DEPTH : (pos.z - (Chunk::DEPTH - 1)) / Chunk::DEPTH;
     auto it = chunks.find(glm::ivec3(chunkX, 0, chunkZ));
@@ -69,13 +361,106 @@ uint8_t World::getBlock(const glm::ivec3& pos) const {
     return 0;
 }
 
-void World::setBlock(const glm::ivec3& pos, uint8_t block) {
+void World::setBlock(const glm::ivec3& pos, BlockId block) {
     int chunkX = pos.x >= 0 ? pos.x / Chunk::WIDTH : (pos.x - (Chunk::WIDTH - 1)) / Chunk::WIDTH;
     int chunkZ = pos.z >= 0 ? pos.z / Chunk::DEPTH : (pos.z - (Chunk::DEPTH - 1)) / Chunk::DEPTH;
     auto it = chunks.find(glm::ivec3(chunkX, 0, chunkZ));
     if (it != chunks.end()) {
         int localX = pos.x - chunkX * Chunk::WIDTH;
         int localZ = pos.z - chunkZ * Chunk::DEPTH;
+        farTerrain.invalidate(it->first);
+        if (patchBlock(pos, block)) return;
         it->second.setBlock(localX, pos.y, localZ, block);
+        invalidateAcrossBorder(pos, it->second);
     }
 }
+
+// After an edit that was not patched: a neighboring chunk's solid block next to
+// the edited one gains or loses the face pointing at it
+void World::invalidateAcrossBorder(const glm::ivec3& pos, const Chunk& edited) {
+    for (const glm::ivec3& side : SIDES) {
+        glm::ivec3 local;
+        Chunk* neighbor = chunkAt(pos + side, local);
+        if (!neighbor || neighbor == &edited || neighbor->getBlock(local.x, local.y, local.z) == 0) continue;
+
+        int section = local.y / Chunk::SECTION_HEIGHT;
+        neighbor->markSectionDirty(section);
+        neighbor->sections[section].interactive = true;
+    }
+}
+
+// Applies a single-block edit by patching the faces it hides or exposes into the
+// affected per-face meshes and uploading just those quads. Returns false without
+// changing anything when one of those sections cannot be patched right now.
+bool World::patchBlock(const glm::ivec3& pos, BlockId block) {
+    static const glm::ivec3 DIRECTIONS[6] = {{0, 1, 0}, {0, -1, 0}, {1, 0, 0}, {-1, 0, 0}, {0, 0, 1}, {0, 0, -1}};
+    if (pos.y < 0 || pos.y >= Chunk::HEIGHT) return false;
+    auto start = std::chrono::steady_clock::now();
+
+    struct FacePatch {
+        Chunk* chunk;
+        glm::ivec3 local;
+        glm::ivec3 block;
+        int face;
+    };
+    struct SectionPatch {
+        Chunk* chunk;
+        int section;
+        std::vector<uint32_t> changedSlots;
+    };
+
+    // The edited block's faces and the faces of its neighbors pointing back at it
+    // (opposite directions differ in the lowest bit)
+    FacePatch faces[12];
+    int faceCount = 0;
+    std::vector<SectionPatch> sections;
+    for (int face = 0; face < 6; ++face) {
+        for (int side = 0; side < 2; ++side) {
+            glm::ivec3 blockPos = side == 0 ? pos : pos + DIRECTIONS[face];
+            if (blockPos.y < 0 || blockPos.y >= Chunk::HEIGHT) continue;
+            glm::ivec3 local;
+            Chunk* chunk = chunkAt(blockPos, local);
+            if (!chunk) continue;
+
+            int section = local.y / Chunk::SECTION_HEIGHT;
+            if (!chunk->canPatch(section, meshFormat)) return false;
+            faces[faceCount++] = {chunk, local, blockPos, side == 0 ? face : face ^ 1};
+            auto known = std::find_if(sections.begin(), sections.end(), [&](const SectionPatch& patch) {
+                return patch.chunk == chunk && patch.section == section;
+            });
+            if (known == sections.end()) sections.push_back({chunk, section, {}});
+        }
+    }
+
+    glm::ivec3 local;
+    chunkAt(pos, local)->setBlock(local.x, local.y, local.z, block, false);
+
+    for (int i = 0; i < faceCount; ++i) {
+        const FacePatch& patch = faces[i];
+        uint8_t owner = Blocks::renderId(getBlock(patch.block));
+        uint8_t neighbor = Blocks::renderId(getBlock(patch.block + DIRECTIONS[patch.face]));
+        uint8_t visible = Blocks::faceVisible(owner, neighbor) ? owner : 0;
+        int section = patch.local.y / Chunk::SECTION_HEIGHT;
+        auto target = std::find_if(sections.begin(), sections.end(), [&](const SectionPatch& s) {
+            return s.chunk == patch.chunk && s.section == section;
+        });
+        ChunkMesher::patchFace(patch.chunk->sections[section], patch.local.x, patch.local.y, patch.local.z,
+                               patch.face, visible, target->changedSlots);
+    }
+    for (SectionPatch& patch : sections) {
+        meshStats.bytesUploaded += patch.chunk->uploadPatch(patch.section, patch.changedSlots, geometry, streamBuffer);
+    }
+
+    meshStats.blocksPatched++;
+    meshStats.patchUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+Chunk* World::chunkAt(const glm::ivec3& pos, glm::ivec3& local) {
+    int chunkX = pos.x >= 0 ? pos.x / Chunk::WIDTH : (pos.x - (Chunk::WIDTH - 1)) / Chunk::WIDTH;
+    int chunkZ = pos.z >= 0 ? pos.z / Chunk::DEPTH : (pos.z - (Chunk::DEPTH - 1)) / Chunk::DEPTH;
+    auto it = chunks.find(glm::ivec3(chunkX, 0, chunkZ));
+    if (it == chunks.end()) return nullptr;
+    local = glm::ivec3(pos.x - chunkX * Chunk::WIDTH, pos.y, pos.z - chunkZ * Chunk::DEPTH);
+    return &it->second;
+}
@@ -1,9 +1,15 @@
 #pragma once
 #include "Chunk.h"
 #include "Shader.h"
+#include "QuadIndexBuffer.h"
+#include "MeshWorkers.h"
+#include "StreamBuffer.h"
+#include "GeometryPool.h"
+#include "FarTerrain.h"
 #include <unordered_map>
 #include <glm/vec3.hpp>
 #include <optional>
+#include <array>
 
 // Simple hash function for glm::ivec3
 namespace std {
@@ -20,17 +26,104 @@ struct RaycastResult {
     glm::ivec3 face;
 };
 
+struct MeshStats {
+    size_t chunks = 0;
+    size_t quads = 0;
+    size_t meshBytes = 0;
+    size_t blockBytes = 0; // Palette-compressed block storage of all chunks
+    size_t uniformSections = 0; // Holding a single id, so stored as just that id
+    size_t indexBytes = 0; // Shared quad index buffer
+    size_t meshesBuilt = 0;
+    size_t meshesDiscarded = 0; // Finished after the chunk was edited again
+    size_t meshJobsPending = 0;
+    size_t chunksWaiting = 0;   // Dirty but missing a neighbor, so not meshed yet
+    double buildMs = 0.0; // Total worker time spent meshing
+    size_t uploadQueueDepth = 0;
+    size_t sectionsUploaded = 0; // Last frame
+    size_t bytesUploaded = 0;    // Last frame
+    bool streaming = false;      // Uploads go through the persistent-mapped StreamBuffer
+    size_t streamWaits = 0;
+    size_t blocksPatched = 0;    // Edits applied to the meshes in place
+    double patchUs = 0.0;
+    size_t drawRanges = 0;       // All in one multi-draw call
+    size_t quadsDrawn = 0;       // After skipping face directions turned away from the camera
+    std::array<size_t, Chunk::LODS> lodChunks{}; // Chunks at each level of detail
+};
+
+// Limits on mesh uploads per frame; at least one section is uploaded regardless
+struct UploadBudget {
+    size_t bytes = 4 * 1024 * 1024;
+    float ms = 2.0f;
+};
+
+struct UploadRequest {
+    glm::ivec3 chunk;
+    int section;
+    float priority; // Lower uploads first
+};
+
 class World {
 public:
     World();
     void render(Shader& shader);
-    void update(const glm::vec3& cameraPos, int distance);
+    // Draws the heightmap terrain beyond the render distance; call before render
+    void renderFarTerrain(Shader& shader);
+    void update(const glm::vec3& cameraPos, const glm::vec3& cameraFront, int distance);
 
     std::optional<RaycastResult> raycast(const glm::vec3& start, const glm::vec3& direction, float maxDist);
-    uint8_t getBlock(const glm::ivec3& pos) const;
-    void setBlock(const glm::ivec3& pos, uint8_t block);
+    BlockId getBlock(const glm::ivec3& pos) const;
+    const Chunk* getChunk(int x, int z) const;
+    void setBlock(const glm::ivec3& pos, BlockId block);
+
+    MeshMode getMeshMode() const { return meshMode; }
+    void setMeshMode(MeshMode mode);
+    MeshFormat getMeshFormat() const { return meshFormat; }
+    void setMeshFormat(MeshFormat format);
+    bool getLodEnabled() const { return lodEnabled; }
+    void setLodEnabled(bool enabled) { lodEnabled = enabled; }
+    bool getFarTerrainEnabled() const { return farTerrainEnabled; }
+    void setFarTerrainEnabled(bool enabled) { farTerrainEnabled = enabled; }
+    const FarTerrainStats& getFarTerrainStats() const { return farTerrain.getStats(); }
+    const MeshStats& getMeshStats() const { return meshStats; }
+    const UploadBudget& getUploadBudget() const { return uploadBudget; }
+    void setUploadBudget(const UploadBudget& budget) { uploadBudget = budget; }
+    const GeometryPoolStats& getGeometryStats() { return geometry.stats(); }
+    MeshCacheStats getMeshCacheStats() const { return meshWorkers.cacheStats(); }
+    void compactGeometry() { geometry.compact(); }
 
 private:
+    GeometryPool geometry; // Declared before chunks so it outlives their allocations
     std::unordered_map<glm::ivec3, Chunk> chunks;
+    MeshMode meshMode = MeshMode::Greedy;
+    MeshFormat meshFormat = MeshFormat::Vertices;
+    bool lodEnabled = true;
+    bool farTerrainEnabled = true;
+    FarTerrain farTerrain;
+    MeshStats meshStats;
+    QuadIndexBuffer quadIndices;
+    StreamBuffer streamBuffer;
+    MeshWorkers meshWorkers;
+    std::vector<MeshResult> finishedMeshes;
+    std::vector<UploadRequest> uploadQueue;
+    UploadBudget uploadBudget;
+    glm::vec3 cameraPos{0.0f};
+    glm::vec3 cameraFront{0.0f, 0.0f, -1.0f};
+    glm::ivec3 cameraChunk{0};
+    int renderDistance = 0;
+    std::vector<int> drawFirsts; // Base vertex or first vertex, depending on format
+    std::vector<int> drawCounts;
+    std::vector<const void*> drawIndices;
     void loadChunk(int x, int z);
+    void invalidateAcrossBorder(const glm::ivec3& pos, const Chunk& edited);
+    bool neighborsLoaded(const glm::ivec3& pos) const;
+    void updateLods();
+    void setChunkLod(Chunk& chunk, int lod);
+    Chunk* chunkAt(const glm::ivec3& pos, glm::ivec3& local);
+    bool patchBlock(const glm::ivec3& pos, BlockId block);
+    void remeshAll();
+    void scheduleMesh(Chunk& chunk);
+    void applyFinishedMeshes();
+    void uploadMeshes();
+    float uploadPriority(const UploadRequest& request) const;
+    uint8_t facingDirections(const glm::ivec3& chunk, int section) const;
 };
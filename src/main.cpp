@@ -9,11 +9,13 @@
 #include <iostream>
 #include <format>
 #include <unordered_map>
+#include <vector>
 #include <algorithm>
 #include "Shader.h"
 #include "stb_image.h"
 #include "Scheduler.h"
 #include "World.h"
+#include "Blocks.h"
 
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -32,6 +34,7 @@ float lastY =  600.0 / 2.0;
 float fov   =  45.0f;
 float cameraSpeed = 15.0f;
 int renderDistance = 4;
+uint8_t placedBlock = Blocks::Brick;
 
 bool debugWindow = false;
 bool vsyncEnabled = true;
@@ -59,7 +62,7 @@ bool keyPressed(int key) {
     return keys[key].pressed;
 }
 
-void processInput(GLFWwindow *window, Shader& shader, World& world) {
+void processInput(GLFWwindow *window, Shader& shader, Shader& faceShader, Shader& terrainShader, World& world) {
     updateKeys(window);
 
     // Exit
@@ -82,8 +85,11 @@ void processInput(GLFWwindow *window, Shader& shader, World& world) {
         else
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     }
-    if (keyJustPressed(GLFW_KEY_F2))
+    if (keyJustPressed(GLFW_KEY_F2)) {
         shader.reload();
+        faceShader.reload();
+        terrainShader.reload();
+    }
     if (keyJustPressed(GLFW_KEY_F3))
         debugWindow = !debugWindow;
 
@@ -113,7 +119,7 @@ void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
                 world->setBlock(raycastResult->blockPos, 0);
             }
             else if (button == GLFW_MOUSE_BUTTON_RIGHT) {
-                world->setBlock(raycastResult->blockPos + raycastResult->face, 1);
+                world->setBlock(raycastResult->blockPos + raycastResult->face, placedBlock);
             }
         }
     }
@@ -168,25 +174,77 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
 }
 
-unsigned int loadTexture(const char* path) {
+// Builds the block texture array from Blocks::TEXTURES, box-filtering every image to one size
+unsigned int loadBlockTextures() {
+    const int SIZE = 256;
     unsigned int texture;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, SIZE, SIZE, Blocks::LAYERS, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    std::vector<unsigned char> pixels(SIZE * SIZE * 4);
+    for (int layer = 0; layer < Blocks::LAYERS; ++layer) {
+        const BlockTexture& source = Blocks::TEXTURES[layer];
+        int width = 0, height = 0, nrChannels;
+        unsigned char* data = stbi_load(source.path, &width, &height, &nrChannels, 3);
+        if (!data) std::cout << "Failed to load texture: " << source.path << std::endl;
+        glm::vec3 tint((source.tint >> 16 & 255) / 255.0f, (source.tint >> 8 & 255) / 255.0f, (source.tint & 255) / 255.0f);
+
+        for (int y = 0; y < SIZE; ++y) {
+            for (int x = 0; x < SIZE; ++x) {
+                glm::vec3 color(1.0f);
+                if (data) {
+                    glm::vec3 sum(0.0f);
+                    int x0 = x * width / SIZE, x1 = std::max(x0 + 1, (x + 1) * width / SIZE);
+                    int y0 = y * height / SIZE, y1 = std::max(y0 + 1, (y + 1) * height / SIZE);
+                    for (int sy = y0; sy < y1; ++sy)
+                        for (int sx = x0; sx < x1; ++sx) {
+                            const unsigned char* in = &data[(sy * width + sx) * 3];
+                            sum += glm::vec3(in[0], in[1], in[2]);
+                        }
+                    color = sum / (255.0f * (x1 - x0) * (y1 - y0));
+                }
+                if (source.tint != 0) {
+                    float brightness = glm::dot(color, glm::vec3(0.299f, 0.587f, 0.114f));
+                    color = glm::min(tint * (0.5f + brightness), glm::vec3(1.0f));
+                }
+                bool border = x < SIZE / 8 || y < SIZE / 8 || x >= SIZE - SIZE / 8 || y >= SIZE - SIZE / 8;
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path, &width, &height, &nrChannels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cout << "Failed to load texture: " << path << std::endl;
+                unsigned char* out = &pixels[(y * SIZE + x) * 4];
+                out[0] = static_cast<unsigned char>(color.x * 255.0f);
+                out[1] = static_cast<unsigned char>(color.y * 255.0f);
+                out[2] = static_cast<unsigned char>(color.z * 255.0f);
+                out[3] = source.cutout && !border ? 0 : 255;
+            }
+        }
+        stbi_image_free(data);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, SIZE, SIZE, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
     }
-    stbi_image_free(data);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    return texture;
+}
+
+// Texture layer (red) and emission (green) per face (x) and block id (y), read by the chunk shaders
+unsigned int createBlockLayerTable() {
+    std::vector<unsigned char> table(256 * 6 * 2, 0);
+    for (int id = 0; id < Blocks::COUNT; ++id) {
+        for (int face = 0; face < 6; ++face) {
+            table[(id * 6 + face) * 2] = Blocks::TYPES[id].layers[face];
+            table[(id * 6 + face) * 2 + 1] = Blocks::TYPES[id].emission;
+        }
+    }
+
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8UI, 6, 256, 0, GL_RG_INTEGER, GL_UNSIGNED_BYTE, table.data());
     return texture;
 }
 
@@ -221,8 +279,10 @@ int main() {
     glEnable(GL_DEPTH_TEST);
 
     Shader shader("src/shader/vert.glsl", "src/shader/frag.glsl");
-    unsigned int texture = loadTexture("assets/brick.jpg");
-    shader.setInt("texture1", texture);
+    Shader faceShader("src/shader/face.vert", "src/shader/frag.glsl");
+    Shader terrainShader("src/shader/terrain.vert", "src/shader/terrain.frag");
+    unsigned int blockTextures = loadBlockTextures();
+    unsigned int blockLayers = createBlockLayerTable();
     Shader selectionShader("src/shader/selection.vert", "src/shader/selection.frag");
 
     float vertices[] = {
@@ -309,27 +369,48 @@ int main() {
         frameCount++;
         scheduler.update();
 
-        processInput(window, shader, world);
-        world.update(cameraPos, renderDistance);
+        processInput(window, shader, faceShader, terrainShader, world);
+        world.update(cameraPos, cameraFront, renderDistance);
 
         glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        shader.use();
-
         ImGui_ImplGlfw_NewFrame();
         ImGui_ImplOpenGL3_NewFrame();
         ImGui::NewFrame();
-        
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        
+
         glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 1000.0f);
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
 
-        world.render(shader);
+        // Far terrain first with its own depth range; the chunks are all nearer and draw over it
+        if (world.getFarTerrainEnabled()) {
+            terrainShader.use();
+            terrainShader.setMat4("view", view);
+            terrainShader.setMat4("projection", glm::perspective(glm::radians(fov), 800.0f / 600.0f, 1.0f, FarTerrain::VIEW_DISTANCE * 2.0f));
+            terrainShader.setVec3("fogColor", clearColor.x, clearColor.y, clearColor.z);
+            terrainShader.setFloat("fogStart", FarTerrain::VIEW_DISTANCE * 0.25f);
+            terrainShader.setFloat("fogEnd", FarTerrain::VIEW_DISTANCE);
+            world.renderFarTerrain(terrainShader);
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+
+        Shader& chunkShader = world.getMeshFormat() == MeshFormat::Faces ? faceShader : shader;
+        chunkShader.use();
+        chunkShader.setInt("faces", 1);
+        chunkShader.setInt("blocks", 0);
+        chunkShader.setInt("blockLayers", 4);
+
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, blockLayers);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, blockTextures);
+
+        // Far enough for the corners of the render distance
+        float chunkFar = std::max(1000.0f, (renderDistance + 1) * Chunk::WIDTH * 1.5f);
+        glm::mat4 projection = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, chunkFar);
+        chunkShader.setMat4("view", view);
+        chunkShader.setMat4("projection", projection);
+
+        world.render(chunkShader);
 
         auto raycastResult = world.raycast(cameraPos, cameraFront, 10.0f);
         if (raycastResult) {
@@ -373,12 +454,83 @@ int main() {
 
                     ImGui::SliderInt("Render Distance", &renderDistance, 1, 100);
 
+                    if (ImGui::BeginCombo("Placed Block", Blocks::TYPES[placedBlock].name)) {
+                        for (int id = 1; id < Blocks::COUNT; ++id) {
+                            if (ImGui::Selectable(Blocks::TYPES[id].name, id == placedBlock))
+                                placedBlock = static_cast<uint8_t>(id);
+                        }
+                        ImGui::EndCombo();
+                    }
+
+                    bool greedy = world.getMeshMode() == MeshMode::Greedy;
+                    if (ImGui::Checkbox("Greedy Meshing", &greedy))
+                        world.setMeshMode(greedy ? MeshMode::Greedy : MeshMode::PerFace);
+                    UploadBudget budget = world.getUploadBudget();
+                    int budgetKB = static_cast<int>(budget.bytes / 1024);
+                    bool budgetChanged = ImGui::SliderInt("Upload Budget (KB)", &budgetKB, 64, 16384);
+                    budgetChanged |= ImGui::SliderFloat("Upload Budget (ms)", &budget.ms, 0.1f, 16.0f);
+                    if (budgetChanged) {
+                        budget.bytes = static_cast<size_t>(budgetKB) * 1024;
+                        world.setUploadBudget(budget);
+                    }
+
+                    bool lod = world.getLodEnabled();
+                    if (ImGui::Checkbox("Level of Detail", &lod))
+                        world.setLodEnabled(lod);
+
+                    bool farTerrain = world.getFarTerrainEnabled();
+                    if (ImGui::Checkbox("Far Terrain", &farTerrain))
+                        world.setFarTerrainEnabled(farTerrain);
+
+                    bool pulled = world.getMeshFormat() == MeshFormat::Faces;
+                    if (ImGui::Checkbox("Vertex Pulling", &pulled))
+                        world.setMeshFormat(pulled ? MeshFormat::Faces : MeshFormat::Vertices);
+
+                    if (ImGui::Button("Defragment Geometry"))
+                        world.compactGeometry();
+
                     //ImGui::Text("Indices: %d", allIndices.size());
                     //ImGui::Text("Vertices: %d", allVertices.size());
 
                     ImGui::EndTabItem();
                 }
                 if (ImGui::BeginTabItem("Stats")) {
+                    const MeshStats& stats = world.getMeshStats();
+                    ImGui::Text(std::format("Chunks: {}", stats.chunks).c_str());
+                    ImGui::Text(std::format("Triangles: {}", stats.quads * 2).c_str());
+                    ImGui::Text(std::format("CPU Mesh Memory: {:.2f} MB ({:.2f} MB in arenas)",
+                        stats.meshBytes / (1024.0 * 1024.0), MeshArena::reservedBytes() / (1024.0 * 1024.0)).c_str());
+                    ImGui::Text(std::format("Block Memory: {:.2f} MB ({:.1f} KB per chunk, {} uniform sections)", stats.blockBytes / (1024.0 * 1024.0),
+                        stats.chunks ? stats.blockBytes / 1024.0 / stats.chunks : 0.0, stats.uniformSections).c_str());
+                    BlockPoolStats pool = BlockPool::stats();
+                    ImGui::Text(std::format("Block Pool: {:.2f} MB in {} slabs, {} blocks used, {} free",
+                        pool.reservedBytes / (1024.0 * 1024.0), pool.slabs, pool.blocksInUse, pool.blocksFree).c_str());
+                    ImGui::Text(std::format("Shared Index Memory: {:.2f} MB", stats.indexBytes / (1024.0 * 1024.0)).c_str());
+                    const GeometryPoolStats& geometry = world.getGeometryStats();
+                    ImGui::Text(std::format("Geometry Pool: {:.2f} / {:.2f} MB in {} ranges",
+                        geometry.usedBytes / (1024.0 * 1024.0), geometry.capacityBytes / (1024.0 * 1024.0), geometry.allocations).c_str());
+                    ImGui::Text(std::format("Fragmentation: {:.1f}% ({} free ranges, largest {:.2f} MB)",
+                        geometry.fragmentation() * 100.0f, geometry.freeRanges, geometry.largestFreeBytes / (1024.0 * 1024.0)).c_str());
+                    ImGui::Text(std::format("Compactions: {} ({} growths)", geometry.compactions, geometry.growths).c_str());
+                    ImGui::Text(std::format("Detail Levels: {} / {} / {} / {} chunks",
+                        stats.lodChunks[0], stats.lodChunks[1], stats.lodChunks[2], stats.lodChunks[3]).c_str());
+                    ImGui::Text(std::format("Draws: {} ranges in 1 call, {} triangles after facing cull", stats.drawRanges, stats.quadsDrawn * 2).c_str());
+                    ImGui::Text(std::format("Meshes Built: {} ({} stale, {} pending, {} waiting on neighbors)",
+                        stats.meshesBuilt, stats.meshesDiscarded, stats.meshJobsPending, stats.chunksWaiting).c_str());
+                    ImGui::Text(std::format("Upload Queue: {} sections", stats.uploadQueueDepth).c_str());
+                    ImGui::Text(std::format("Uploaded: {:.1f} KB in {} sections this frame", stats.bytesUploaded / 1024.0, stats.sectionsUploaded).c_str());
+                    ImGui::Text(std::format("Stream Buffer: {} ({} stalls)", stats.streaming ? "on" : "off", stats.streamWaits).c_str());
+                    if (stats.blocksPatched > 0)
+                        ImGui::Text(std::format("Patched Edits: {} (avg {:.1f} us)", stats.blocksPatched, stats.patchUs / stats.blocksPatched).c_str());
+                    const FarTerrainStats& far = world.getFarTerrainStats();
+                    ImGui::Text(std::format("Far Terrain: {} tiles drawn, {} resident, {} built ({} pending), {:.1f} km",
+                        far.tilesDrawn, far.tilesResident, far.tilesBuilt, far.tilesPending, FarTerrain::VIEW_DISTANCE / 1000.0f).c_str());
+                    MeshCacheStats cache = world.getMeshCacheStats();
+                    ImGui::Text(std::format("Mesh Cache: {:.1f}% hits ({} / {}), {} entries ({:.2f} MB), {} collisions",
+                        cache.hitRate() * 100.0f, cache.hits, cache.hits + cache.misses, cache.entries, cache.bytes / (1024.0 * 1024.0),
+                        cache.collisions).c_str());
+                    if (stats.meshesBuilt > 0)
+                        ImGui::Text(std::format("Avg Mesh Time: {:.3f} ms", stats.buildMs / stats.meshesBuilt).c_str());
                     ImGui::EndTabItem();
                 }
                 ImGui::EndTabBar();
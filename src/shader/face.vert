@@ -0,0 +1,61 @@
+#version 330 core
+// Vertex-pulling variant of vert.glsl: draws six vertices per quad record
+// (layout documented in PackedVertex.h) and builds the quad from gl_VertexID.
+
+out vec2 TexCoord;
+flat out uint Layer;
+out float Shade;
+
+uniform usamplerBuffer faces;
+uniform isamplerBuffer pages;
+uniform usampler2D blockLayers; // Texture layer and emission per face (x) and block (y)
+uniform mat4 view;
+uniform mat4 projection;
+
+// Words per GeometryPool page; each page belongs to one chunk
+const int PAGE_WORDS = 256;
+
+// Directional shading per face: Top, Bottom, Right, Left, Front, Back
+const float FACE_SHADE[6] = float[](1.0, 0.5, 0.8, 0.8, 0.65, 0.65);
+
+// Normal axis, plane offset along it, width axis, height axis for Top, Bottom, Right, Left, Front, Back
+const ivec4 FACES[6] = ivec4[](
+    ivec4(1, 1, 0, 2), ivec4(1, 0, 0, 2),
+    ivec4(0, 1, 1, 2), ivec4(0, 0, 1, 2),
+    ivec4(2, 1, 0, 1), ivec4(2, 0, 0, 1)
+);
+
+// Corners in the same {0, 1, 2, 2, 3, 0} order as the indexed path
+const vec2 CORNERS[6] = vec2[](
+    vec2(0, 0), vec2(1, 0), vec2(1, 1),
+    vec2(1, 1), vec2(0, 1), vec2(0, 0)
+);
+
+void main() {
+    uint record = texelFetch(faces, gl_VertexID / 6).r;
+    vec3 corner = vec3(record & 15u, (record >> 4) & 127u, (record >> 11) & 15u);
+    uint face = (record >> 15) & 7u;
+    uint block = (record >> 18) & 255u;
+    vec2 size = vec2(((record >> 26) & 7u) + 1u, ((record >> 29) & 7u) + 1u);
+
+    uvec2 type = texelFetch(blockLayers, ivec2(face, block), 0).rg;
+    Layer = type.r;
+    Shade = mix(FACE_SHADE[face], 1.0, float(type.g) / 15.0);
+
+    ivec4 f = FACES[face];
+    corner[f.x] += float(f.y);
+    corner[f.z] += CORNERS[gl_VertexID % 6].x * size.x;
+    corner[f.w] += CORNERS[gl_VertexID % 6].y * size.y;
+
+    // Texture repeats once per block across the face plane
+    if (face < 2u)
+        TexCoord = vec2(corner.x, face == 0u ? -corner.z : corner.z);
+    else if (face < 4u)
+        TexCoord = corner.yz;
+    else
+        TexCoord = corner.xy;
+
+    ivec2 chunk = texelFetch(pages, gl_VertexID / 6 / PAGE_WORDS).xy;
+    vec3 origin = vec3(chunk.x * 16, 0, chunk.y * 16);
+    gl_Position = projection * view * vec4(origin + corner - 0.5, 1.0);
+}
@@ -1,8 +1,13 @@
 #version 330 core
 out vec4 FragColor;
 in vec2 TexCoord;
-uniform sampler2D texture1;
+flat in uint Layer;
+in float Shade;
+uniform sampler2DArray blocks;
 
 void main() {
-    FragColor = texture(texture1, TexCoord);
+    vec4 color = texture(blocks, vec3(TexCoord, Layer));
+    // Cut-out textures like glass are see-through where their alpha is low
+    if (color.a < 0.5) discard;
+    FragColor = vec4(color.rgb * Shade, 1.0);
 }
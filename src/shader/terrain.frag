@@ -0,0 +1,27 @@
+#version 330 core
+out vec4 FragColor;
+in vec3 Normal;
+in vec2 WorldXZ;
+in float Distance;
+
+// Areas drawn by something finer, as min x, min z, max x, max z in blocks
+uniform vec4 voxelHole;
+uniform vec4 finerHole;
+uniform vec3 fogColor;
+uniform float fogStart;
+uniform float fogEnd;
+
+const vec3 GRASS = vec3(0.36, 0.55, 0.25);
+const vec3 LIGHT = normalize(vec3(0.4, 1.0, 0.3));
+
+bool inside(vec4 rect) {
+    return all(greaterThanEqual(WorldXZ, rect.xy)) && all(lessThan(WorldXZ, rect.zw));
+}
+
+void main() {
+    if (inside(voxelHole) || inside(finerHole)) discard;
+
+    float light = 0.55 + 0.45 * max(dot(normalize(Normal), LIGHT), 0.0);
+    float fog = clamp((Distance - fogStart) / (fogEnd - fogStart), 0.0, 1.0);
+    FragColor = vec4(mix(GRASS * light, fogColor, fog), 1.0);
+}
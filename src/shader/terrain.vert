@@ -0,0 +1,45 @@
+#version 330 core
+// Far terrain tile drawn by FarTerrain: a grid of cells whose heights come from
+// the tile's slot in the height texture array, LAYER_TILES x LAYER_TILES slots
+// per layer. The ring of vertices just outside the grid is pulled back onto its
+// edge and lowered, forming a skirt that hides the cracks against tiles of other
+// levels.
+layout (location = 0) in ivec2 aCell;
+
+out vec3 Normal;
+out vec2 WorldXZ;
+out float Distance;
+
+uniform sampler2DArray heights;
+uniform int slot;
+uniform vec2 origin;     // Block coordinates of the tile's first vertex
+uniform float cellSize;  // Blocks
+uniform mat4 view;
+uniform mat4 projection;
+
+const int TILE_CELLS = 16; // Keep in sync with FarTerrain::TILE_CELLS
+const int LAYER_TILES = 2; // Keep in sync with FarTerrain::LAYER_TILES
+const float SKIRT_CELLS = 2.0;
+
+float heightAt(ivec2 cell) {
+    ivec2 corner = ivec2(slot % LAYER_TILES, slot / LAYER_TILES % LAYER_TILES) * (TILE_CELLS + 1);
+    int layer = slot / (LAYER_TILES * LAYER_TILES);
+    return texelFetch(heights, ivec3(corner + clamp(cell, ivec2(0), ivec2(TILE_CELLS)), layer), 0).r;
+}
+
+void main() {
+    ivec2 cell = clamp(aCell, ivec2(0), ivec2(TILE_CELLS));
+    float height = heightAt(cell);
+    if (cell != aCell) height -= SKIRT_CELLS * cellSize;
+
+    float dx = heightAt(cell + ivec2(1, 0)) - heightAt(cell - ivec2(1, 0));
+    float dz = heightAt(cell + ivec2(0, 1)) - heightAt(cell - ivec2(0, 1));
+    Normal = normalize(vec3(-dx, 2.0 * cellSize, -dz));
+
+    // Blocks are centered on integer coordinates, so their top surface sits half a block lower
+    vec3 position = vec3(origin.x + cell.x * cellSize, height, origin.y + cell.y * cellSize);
+    WorldXZ = position.xz;
+    vec4 viewPosition = view * vec4(position - 0.5, 1.0);
+    Distance = length(viewPosition.xyz);
+    gl_Position = projection * viewPosition;
+}
@@ -1,14 +1,40 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexCoord;
+layout (location = 0) in uint aPacked;
 
 out vec2 TexCoord;
+flat out uint Layer;
+out float Shade;
 
-uniform mat4 model;
+uniform isamplerBuffer pages;
+uniform usampler2D blockLayers; // Texture layer and emission per face (x) and block (y)
 uniform mat4 view;
 uniform mat4 projection;
 
+// Words per GeometryPool page; each page belongs to one chunk
+const int PAGE_WORDS = 256;
+
+// Directional shading per face: Top, Bottom, Right, Left, Front, Back
+const float FACE_SHADE[6] = float[](1.0, 0.5, 0.8, 0.8, 0.65, 0.65);
+
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    TexCoord = aTexCoord;
+    // Layout documented in PackedVertex.h
+    vec3 corner = vec3(aPacked & 31u, (aPacked >> 5) & 255u, (aPacked >> 13) & 31u);
+    uint face = (aPacked >> 18) & 7u;
+    uint block = (aPacked >> 21) & 255u;
+
+    uvec2 type = texelFetch(blockLayers, ivec2(face, block), 0).rg;
+    Layer = type.r;
+    Shade = mix(FACE_SHADE[face], 1.0, float(type.g) / 15.0);
+
+    // Texture repeats once per block across the face plane
+    if (face < 2u)
+        TexCoord = vec2(corner.x, face == 0u ? -corner.z : corner.z);
+    else if (face < 4u)
+        TexCoord = corner.yz;
+    else
+        TexCoord = corner.xy;
+
+    ivec2 chunk = texelFetch(pages, gl_VertexID / PAGE_WORDS).xy;
+    vec3 origin = vec3(chunk.x * 16, 0, chunk.y * 16);
+    gl_Position = projection * view * vec4(origin + corner - 0.5, 1.0);
 }